@@ -6,11 +6,15 @@
 /* Stores keys from the keyboard and serial port. */
 static struct intq buffer;
 
+/* Woken whenever a key is added to BUFFER. */
+static struct wait_queue waiters;
+
 /* Initializes the input buffer. */
 void
 input_init (void) 
 {
   intq_init (&buffer);
+  wait_queue_init (&waiters);
 }
 
 /* Adds a key to the input buffer.
@@ -23,6 +27,7 @@ input_putc (uint8_t key)
 
   intq_putc (&buffer, key);
   serial_notify ();
+  wait_queue_wake (&waiters);
 }
 
 /* Retrieves a key from the input buffer.
@@ -50,3 +55,20 @@ input_full (void)
   ASSERT (intr_get_level () == INTR_OFF);
   return intq_full (&buffer);
 }
+
+/* Returns true if input_getc () would return without waiting. */
+bool
+input_ready (void)
+{
+  enum intr_level old_level = intr_disable ();
+  bool ready = !intq_empty (&buffer);
+  intr_set_level (old_level);
+  return ready;
+}
+
+/* Returns the wait queue woken whenever a key comes in. */
+struct wait_queue *
+input_waiters (void)
+{
+  return &waiters;
+}
@@ -4,9 +4,13 @@
 #include <stdbool.h>
 #include <stdint.h>
 
+struct wait_queue;
+
 void input_init (void);
 void input_putc (uint8_t);
 uint8_t input_getc (void);
 bool input_full (void);
+bool input_ready (void);
+struct wait_queue *input_waiters (void);
 
 #endif /* devices/input.h */
@@ -9,6 +9,9 @@
 #ifdef USERPROG
 #include "userprog/exception.h"
 #endif
+#ifdef VM
+#include "vm/same-page.h"
+#endif
 #ifdef FILESYS
 #include "devices/block.h"
 #include "filesys/filesys.h"
@@ -130,4 +133,7 @@ print_stats (void)
 #ifdef USERPROG
   exception_print_stats ();
 #endif
+#ifdef VM
+  same_page_print_stats ();
+#endif
 }
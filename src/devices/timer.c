@@ -104,21 +104,44 @@ thread_timer_less (const struct list_elem *a,
 void
 timer_sleep (int64_t ticks) 
 {
-  int64_t start = timer_ticks ();
-
   ASSERT (intr_get_level () == INTR_ON);
 
   struct thread_timer thread_timer;
-  thread_timer.thread = thread_current ();
-  thread_timer.wake_up_tick = start + ticks;
-  sema_init (&thread_timer.sema, 0);
+  struct semaphore sema;
+  sema_init (&sema, 0);
+  timer_start (&thread_timer, ticks, &sema);
+  sema_down (&sema);
+}
+
+/* Starts TIMER, which ups SEMA once, about TICKS timer ticks from now,
+   unless it is cancelled first.  Lets a thread wait on SEMA for the
+   first of several events, one of them a timeout. */
+void
+timer_start (struct thread_timer *timer, int64_t ticks,
+             struct semaphore *sema)
+{
+  timer->thread = thread_current ();
+  timer->wake_up_tick = timer_ticks () + ticks;
+  timer->sema = sema;
 
   enum intr_level old_level = intr_disable ();
-  list_insert_ordered (&sleep_list, &thread_timer.elem, &thread_timer_less,
+  list_insert_ordered (&sleep_list, &timer->elem, &thread_timer_less,
 		  NULL);
   intr_set_level (old_level);
+}
 
-  sema_down (&thread_timer.sema);
+/* Stops TIMER, started by timer_start (), if it has not gone off. */
+void
+timer_cancel (struct thread_timer *timer)
+{
+  enum intr_level old_level = intr_disable ();
+  for (struct list_elem *e = list_begin (&sleep_list);
+       e != list_end (&sleep_list); e = list_next (e))
+    if (e == &timer->elem) {
+      list_remove (e);
+      break;
+    }
+  intr_set_level (old_level);
 }
 
 /* Sleeps for approximately MS milliseconds.  Interrupts must be
@@ -203,7 +226,7 @@ timer_interrupt (struct intr_frame *args UNUSED)
 
     if (timer_ticks () >= list_head -> wake_up_tick) {
       list_pop_front (&sleep_list);
-      sema_up (&list_head -> sema);
+      sema_up (list_head -> sema);
     } else {
       break;
     }
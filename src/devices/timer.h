@@ -14,7 +14,7 @@ struct thread_timer {
   struct thread *thread;          /* The sleeping thread. */
   int64_t wake_up_tick;           /* The tick upon which the thread should wake up. */
   struct list_elem elem;          /* Making the struct an element of the list. */
-  struct semaphore sema;          /* Used for blocking and unblocking the thread. */
+  struct semaphore *sema;         /* Upped at WAKE_UP_TICK. */
 };
 
 void timer_init (void);
@@ -25,6 +25,8 @@ int64_t timer_elapsed (int64_t);
 
 /* Sleep and yield the CPU to other threads. */
 void timer_sleep (int64_t ticks);
+void timer_start (struct thread_timer *, int64_t ticks, struct semaphore *);
+void timer_cancel (struct thread_timer *);
 void timer_msleep (int64_t milliseconds);
 void timer_usleep (int64_t microseconds);
 void timer_nsleep (int64_t nanoseconds);
@@ -38,17 +38,11 @@ main (int argc, char *argv[])
     }
 
   /* Copy data. */
-  for (;;) 
+  int size = filesize (in_fd);
+  if (copy_file_range (in_fd, out_fd, size) != size) 
     {
-      char buffer[1024];
-      int bytes_read = read (in_fd, buffer, sizeof buffer);
-      if (bytes_read == 0)
-        break;
-      if (write (out_fd, buffer, bytes_read) != bytes_read) 
-        {
-          printf ("%s: write failed\n", argv[2]);
-          return EXIT_FAILURE;
-        }
+      printf ("%s: write failed\n", argv[2]);
+      return EXIT_FAILURE;
     }
 
   return EXIT_SUCCESS;
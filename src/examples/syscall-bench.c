@@ -0,0 +1,64 @@
+/* syscall-bench.c
+
+   Measures the latency of a system call that does no work, once
+   entering the kernel with "int $0x30" and once with SYSENTER.
+
+   Usage: syscall-bench [ROUNDS] */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <syscall.h>
+
+/* Reads the CPU's time-stamp counter. */
+static uint64_t
+rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Makes ROUNDS system calls and returns the average number of
+   cycles each took.  tell() on a file descriptor that is not open
+   only checks its argument in the kernel and returns. */
+static uint64_t
+run_bench (int rounds)
+{
+  uint64_t start, end;
+  int i;
+
+  start = rdtsc ();
+  for (i = 0; i < rounds; i++)
+    tell (-1);
+  end = rdtsc ();
+  return (end - start) / rounds;
+}
+
+int
+main (int argc, char *argv[])
+{
+  int rounds = argc > 1 ? atoi (argv[1]) : 100000;
+  bool sysenter = syscall_sysenter;
+
+  if (rounds <= 0)
+    {
+      printf ("usage: syscall-bench [ROUNDS]\n");
+      return EXIT_FAILURE;
+    }
+
+  printf ("syscall-bench: %d null system calls\n", rounds);
+  syscall_sysenter = false;
+  printf ("syscall-bench: %"PRIu64" cycles/call with int $0x30\n",
+          run_bench (rounds));
+  if (sysenter)
+    {
+      syscall_sysenter = true;
+      printf ("syscall-bench: %"PRIu64" cycles/call with sysenter\n",
+              run_bench (rounds));
+    }
+  else
+    printf ("syscall-bench: CPU does not support sysenter\n");
+
+  return EXIT_SUCCESS;
+}
@@ -6,6 +6,9 @@
 #include "filesys/free-map.h"
 #include "filesys/inode.h"
 #include "filesys/directory.h"
+#ifdef VM
+#include "vm/page-cache.h"
+#endif
 
 /* Partition that contains the file system. */
 struct block *fs_device;
@@ -36,6 +39,9 @@ filesys_init (bool format)
 void
 filesys_done (void) 
 {
+#ifdef VM
+  page_cache_flush ();
+#endif
   free_map_close ();
 }
 
@@ -59,6 +65,25 @@ filesys_create (const char *name, off_t initial_size)
   return success;
 }
 
+/* Creates a file of INITIAL_SIZE bytes that no directory refers to,
+   and returns its inode, or a null pointer on failure.  The file is
+   deleted when its inode is closed for the last time. */
+struct inode *
+filesys_create_anonymous (off_t initial_size)
+{
+  block_sector_t inode_sector = 0;
+  struct inode *inode = NULL;
+  bool success = (free_map_allocate (1, &inode_sector)
+                  && inode_create (inode_sector, initial_size)
+                  && (inode = inode_open (inode_sector)) != NULL);
+  if (!success && inode_sector != 0)
+    free_map_release (inode_sector, 1);
+  if (inode != NULL)
+    inode_remove (inode);
+
+  return inode;
+}
+
 /* Opens the file with the given NAME.
    Returns the new file if successful or a null pointer
    otherwise.
@@ -17,6 +17,7 @@ struct lock filesys_lock;
 void filesys_init (bool format);
 void filesys_done (void);
 bool filesys_create (const char *name, off_t initial_size);
+struct inode *filesys_create_anonymous (off_t initial_size);
 struct file *filesys_open (const char *name);
 bool filesys_remove (const char *name);
 
@@ -6,6 +6,9 @@
 #include "filesys/filesys.h"
 #include "filesys/free-map.h"
 #include "threads/malloc.h"
+#ifdef VM
+#include "vm/page-cache.h"
+#endif
 
 /* Identifies an inode. */
 #define INODE_MAGIC 0x494e4f44
@@ -172,6 +175,12 @@ inode_close (struct inode *inode)
     {
       /* Remove from inode list and release lock. */
       list_remove (&inode->elem);
+
+#ifdef VM
+      /* Drop the cached pages, there is no need to write them back
+         if the file is going away. */
+      page_cache_drop_inode (inode, !inode->removed);
+#endif
  
       /* Deallocate blocks if removed. */
       if (inode->removed) 
@@ -198,7 +207,22 @@ inode_remove (struct inode *inode)
    Returns the number of bytes actually read, which may be less
    than SIZE if an error occurs or end of file is reached. */
 off_t
-inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset) 
+inode_read_at (struct inode *inode, void *buffer, off_t size, off_t offset) 
+{
+#ifdef VM
+  return page_cache_read (inode, buffer, size, offset);
+#else
+  return inode_read_direct (inode, buffer, size, offset);
+#endif
+}
+
+/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET,
+   straight from disk, bypassing the page cache.
+   Returns the number of bytes actually read, which may be less
+   than SIZE if an error occurs or end of file is reached. */
+off_t
+inode_read_direct (struct inode *inode, void *buffer_, off_t size,
+                   off_t offset) 
 {
   uint8_t *buffer = buffer_;
   off_t bytes_read = 0;
@@ -255,8 +279,25 @@ inode_read_at (struct inode *inode, void *buffer_, off_t size, off_t offset)
    (Normally a write at end of file would extend the inode, but
    growth is not yet implemented.) */
 off_t
-inode_write_at (struct inode *inode, const void *buffer_, off_t size,
+inode_write_at (struct inode *inode, const void *buffer, off_t size,
                 off_t offset) 
+{
+#ifdef VM
+  if (inode->deny_write_cnt)
+    return 0;
+  return page_cache_write (inode, buffer, size, offset);
+#else
+  return inode_write_direct (inode, buffer, size, offset);
+#endif
+}
+
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET,
+   straight to disk, bypassing the page cache.
+   Returns the number of bytes actually written, which may be
+   less than SIZE if end of file is reached or an error occurs. */
+off_t
+inode_write_direct (struct inode *inode, const void *buffer_, off_t size,
+                    off_t offset) 
 {
   const uint8_t *buffer = buffer_;
   off_t bytes_written = 0;
@@ -16,6 +16,9 @@ void inode_close (struct inode *);
 void inode_remove (struct inode *);
 off_t inode_read_at (struct inode *, void *, off_t size, off_t offset);
 off_t inode_write_at (struct inode *, const void *, off_t size, off_t offset);
+off_t inode_read_direct (struct inode *, void *, off_t size, off_t offset);
+off_t inode_write_direct (struct inode *, const void *, off_t size,
+                          off_t offset);
 void inode_deny_write (struct inode *);
 void inode_allow_write (struct inode *);
 off_t inode_length (const struct inode *);
@@ -28,7 +28,33 @@ enum
     SYS_MKDIR,                  /* Create a directory. */
     SYS_READDIR,                /* Reads a directory entry. */
     SYS_ISDIR,                  /* Tests if a fd represents a directory. */
-    SYS_INUMBER                 /* Returns the inode number for a fd. */
+    SYS_INUMBER,                /* Returns the inode number for a fd. */
+
+    /* Extensions. */
+    SYS_SET_RSS_LIMIT,          /* Limit the resident set of this process. */
+    SYS_MSYNC,                  /* Write back a range of a memory mapping. */
+    SYS_MADVISE,                /* Give paging hints for a range of memory. */
+    SYS_RING_SETUP,             /* Register a system call ring. */
+    SYS_RING_ENTER,             /* Carry out the requests in the ring. */
+    SYS_PREAD,                  /* Read from a file at a given position. */
+    SYS_PWRITE,                 /* Write to a file at a given position. */
+    SYS_READV,                  /* Read from a file into several buffers. */
+    SYS_WRITEV,                 /* Write several buffers to a file. */
+    SYS_COPY_FILE_RANGE,        /* Copy data from one file to another. */
+    SYS_AIO_READ,               /* Start reading from a file. */
+    SYS_AIO_WRITE,              /* Start writing to a file. */
+    SYS_AIO_WAIT,               /* Wait for an asynchronous read or write. */
+    SYS_AIO_POLL,               /* Check on an asynchronous read or write. */
+    SYS_PIPE,                   /* Create a pipe. */
+    SYS_DUP2,                   /* Duplicate a file descriptor. */
+    SYS_POLL,                   /* Wait for I/O on several fds. */
+    SYS_SHM_OPEN,               /* Open a shared memory segment. */
+    SYS_SHM_UNLINK,             /* Remove a shared memory segment. */
+    SYS_FUTEX_WAIT,             /* Wait for a word to change. */
+    SYS_FUTEX_WAKE,             /* Wake threads waiting on a word. */
+    SYS_THREAD_SPAWN,           /* Start a thread in the process. */
+    SYS_THREAD_JOIN,            /* Wait for a thread to exit. */
+    SYS_THREAD_EXIT             /* End the calling thread. */
   };
 
 #endif /* lib/syscall-nr.h */
@@ -0,0 +1,60 @@
+#ifndef __LIB_SYSCALL_RING_H
+#define __LIB_SYSCALL_RING_H
+
+/* Submission/completion ring for batching system calls.
+
+   A process registers a struct syscall_ring in its own memory
+   with ring_setup().  It queues a request by filling in
+   sq[sq_tail % RING_ENTRIES] and incrementing sq_tail, then has
+   the kernel carry out every queued request with a single
+   ring_enter().  The kernel carries them out in order, advancing
+   sq_head, and posts a completion for each one at
+   cq[cq_tail % RING_ENTRIES], advancing cq_tail.  The process
+   reaps completions by advancing cq_head.  The kernel stops
+   early when the completion queue is full.
+
+   The four indexes only ever increase, wrapping around when they
+   overflow, so that a queue holds TAIL - HEAD entries. */
+
+/* Entries in each queue.  A power of 2. */
+#define RING_ENTRIES 32
+
+/* Request operations. */
+enum ring_op
+  {
+    RING_READ,                  /* read (fd, buffer, length). */
+    RING_WRITE,                 /* write (fd, buffer, length). */
+    RING_SEEK                   /* seek (fd, length). */
+  };
+
+/* A request. */
+struct ring_sqe
+  {
+    int op;                     /* A ring_op. */
+    int fd;                     /* File descriptor. */
+    void *buffer;               /* Buffer of RING_READ and RING_WRITE. */
+    unsigned length;            /* Length, or position for RING_SEEK. */
+    unsigned user_data;         /* Passed on to the completion. */
+  };
+
+/* A completion. */
+struct ring_cqe
+  {
+    unsigned user_data;         /* From the request. */
+    int result;                 /* Return value of the system call, 0
+                                   for RING_SEEK, -1 if the request
+                                   was invalid. */
+  };
+
+/* A submission queue and a completion queue. */
+struct syscall_ring
+  {
+    unsigned sq_head;           /* Advanced by the kernel. */
+    unsigned sq_tail;           /* Advanced by the process. */
+    unsigned cq_head;           /* Advanced by the process. */
+    unsigned cq_tail;           /* Advanced by the kernel. */
+    struct ring_sqe sq[RING_ENTRIES];
+    struct ring_cqe cq[RING_ENTRIES];
+  };
+
+#endif /* lib/syscall-ring.h */
@@ -3,8 +3,22 @@
 int main (int, char *[]);
 void _start (int argc, char *argv[]);
 
+/* CPUID.1:EDX flag telling that SYSENTER and SYSEXIT are supported. */
+#define CPUID_SEP 0x00000800
+
+/* Returns true if the CPU supports SYSENTER.  The kernel sets it up
+   whenever it does. */
+static bool
+has_sysenter (void)
+{
+  unsigned eax = 1, ebx, ecx, edx;
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  return (edx & CPUID_SEP) != 0;
+}
+
 void
 _start (int argc, char *argv[]) 
 {
+  syscall_sysenter = has_sysenter ();
   exit (main (argc, argv));
 }
@@ -0,0 +1,92 @@
+#include <synch.h>
+#include <limits.h>
+#include <syscall.h>
+
+/* Initializes mutex M as free. */
+void
+mutex_init (struct mutex *m)
+{
+  m->state = 0;
+}
+
+/* Acquires mutex M, waiting in the kernel if it is held.  Taken from
+   U. Drepper, "Futexes Are Tricky": a waiter sets the state to 2, so
+   that mutex_unlock () knows to wake it, and the common case of a
+   free mutex costs a single atomic instruction. */
+void
+mutex_lock (struct mutex *m)
+{
+  int c = __sync_val_compare_and_swap (&m->state, 0, 1);
+  if (c == 0)
+    return;
+
+  if (c != 2)
+    c = __sync_lock_test_and_set (&m->state, 2);
+  while (c != 0)
+    {
+      futex_wait (&m->state, 2);
+      c = __sync_lock_test_and_set (&m->state, 2);
+    }
+}
+
+/* Acquires mutex M if it is free.  Returns true if successful,
+   false if M is held. */
+bool
+mutex_trylock (struct mutex *m)
+{
+  return __sync_bool_compare_and_swap (&m->state, 0, 1);
+}
+
+/* Releases mutex M, which the caller must hold, and wakes one thread
+   waiting for it, if any. */
+void
+mutex_unlock (struct mutex *m)
+{
+  if (__sync_fetch_and_sub (&m->state, 1) != 1)
+    {
+      m->state = 0;
+      futex_wake (&m->state, 1);
+    }
+}
+
+/* Initializes condition variable C. */
+void
+condvar_init (struct condvar *c)
+{
+  c->seq = 0;
+}
+
+/* Atomically releases mutex M and waits for C to be signaled, then
+   reacquires M before returning.  As with any condition variable,
+   the caller must recheck its condition afterward. */
+void
+condvar_wait (struct condvar *c, struct mutex *m)
+{
+  int seq = c->seq;
+
+  /* A signal between the unlock and the wait changes SEQ, which makes
+     futex_wait () return at once instead of missing it. */
+  mutex_unlock (m);
+  futex_wait (&c->seq, seq);
+
+  /* Other threads may be waiting for M, mark it contended so that our
+     mutex_unlock () wakes them. */
+  while (__sync_lock_test_and_set (&m->state, 2) != 0)
+    futex_wait (&m->state, 2);
+}
+
+/* Wakes one thread waiting on C, if any. */
+void
+condvar_signal (struct condvar *c)
+{
+  __sync_fetch_and_add (&c->seq, 1);
+  futex_wake (&c->seq, 1);
+}
+
+/* Wakes every thread waiting on C. */
+void
+condvar_broadcast (struct condvar *c)
+{
+  __sync_fetch_and_add (&c->seq, 1);
+  futex_wake (&c->seq, INT_MAX);
+}
@@ -0,0 +1,34 @@
+#ifndef __LIB_USER_SYNCH_H
+#define __LIB_USER_SYNCH_H
+
+#include <stdbool.h>
+
+/* A lock for the threads of a process, or for processes sharing
+   memory.  Taking and releasing a free lock makes no system call;
+   only threads that have to wait enter the kernel, see futex_wait (). */
+struct mutex
+  {
+    int state;          /* 0 = free, 1 = held, 2 = held with waiters. */
+  };
+
+#define MUTEX_INITIALIZER { 0 }
+
+void mutex_init (struct mutex *);
+void mutex_lock (struct mutex *);
+bool mutex_trylock (struct mutex *);
+void mutex_unlock (struct mutex *);
+
+/* A condition variable, used together with a mutex. */
+struct condvar
+  {
+    int seq;            /* Changed by every signal and broadcast. */
+  };
+
+#define CONDVAR_INITIALIZER { 0 }
+
+void condvar_init (struct condvar *);
+void condvar_wait (struct condvar *, struct mutex *);
+void condvar_signal (struct condvar *);
+void condvar_broadcast (struct condvar *);
+
+#endif /* lib/user/synch.h */
@@ -1,16 +1,30 @@
 #include <syscall.h>
 #include "../syscall-nr.h"
 
+/* See syscall.h. */
+bool syscall_sysenter;
+
+/* Enters the kernel once the system call number and arguments have
+   been pushed on the stack: with SYSENTER if syscall_sysenter is set,
+   passing the stack pointer in ECX and the address to return to in
+   EDX, otherwise with "int $0x30".  The kernel finds the arguments on
+   the stack the same way either way. */
+#define SYSCALL_ENTER                                           \
+        "cmpb $0, syscall_sysenter; je 1f; "                    \
+        "movl %%esp, %%ecx; movl $2f, %%edx; sysenter; "        \
+        "1: int $0x30; 2: "
+
 /* Invokes syscall NUMBER, passing no arguments, and returns the
    return value as an `int'. */
 #define syscall0(NUMBER)                                        \
         ({                                                      \
           int retval;                                           \
           asm volatile                                          \
-            ("pushl %[number]; int $0x30; addl $4, %%esp"       \
+            ("pushl %[number]; " SYSCALL_ENTER                  \
+             "addl $4, %%esp"                                   \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER)                          \
-               : "memory");                                     \
+               : "ecx", "edx", "cc", "memory");                 \
           retval;                                               \
         })
 
@@ -20,11 +34,12 @@
         ({                                                               \
           int retval;                                                    \
           asm volatile                                                   \
-            ("pushl %[arg0]; pushl %[number]; int $0x30; addl $8, %%esp" \
+            ("pushl %[arg0]; pushl %[number]; " SYSCALL_ENTER            \
+             "addl $8, %%esp"                                            \
                : "=a" (retval)                                           \
                : [number] "i" (NUMBER),                                  \
                  [arg0] "g" (ARG0)                                       \
-               : "memory");                                              \
+               : "ecx", "edx", "cc", "memory");                          \
           retval;                                                        \
         })
 
@@ -35,12 +50,13 @@
           int retval;                                           \
           asm volatile                                          \
             ("pushl %[arg1]; pushl %[arg0]; "                   \
-             "pushl %[number]; int $0x30; addl $12, %%esp"      \
+             "pushl %[number]; " SYSCALL_ENTER                  \
+             "addl $12, %%esp"                                  \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER),                         \
                  [arg0] "g" (ARG0),                             \
                  [arg1] "g" (ARG1)                              \
-               : "memory");                                     \
+               : "ecx", "edx", "cc", "memory");                 \
           retval;                                               \
         })
 
@@ -51,13 +67,34 @@
           int retval;                                           \
           asm volatile                                          \
             ("pushl %[arg2]; pushl %[arg1]; pushl %[arg0]; "    \
-             "pushl %[number]; int $0x30; addl $16, %%esp"      \
+             "pushl %[number]; " SYSCALL_ENTER                  \
+             "addl $16, %%esp"                                  \
                : "=a" (retval)                                  \
                : [number] "i" (NUMBER),                         \
                  [arg0] "g" (ARG0),                             \
                  [arg1] "g" (ARG1),                             \
                  [arg2] "g" (ARG2)                              \
-               : "memory");                                     \
+               : "ecx", "edx", "cc", "memory");                 \
+          retval;                                               \
+        })
+
+/* Invokes syscall NUMBER, passing arguments ARG0, ARG1, ARG2,
+   and ARG3, and returns the return value as an `int'. */
+#define syscall4(NUMBER, ARG0, ARG1, ARG2, ARG3)                \
+        ({                                                      \
+          int retval;                                           \
+          asm volatile                                          \
+            ("pushl %[arg3]; pushl %[arg2]; pushl %[arg1]; "    \
+             "pushl %[arg0]; "                                  \
+             "pushl %[number]; " SYSCALL_ENTER                  \
+             "addl $20, %%esp"                                  \
+               : "=a" (retval)                                  \
+               : [number] "i" (NUMBER),                         \
+                 [arg0] "g" (ARG0),                             \
+                 [arg1] "g" (ARG1),                             \
+                 [arg2] "g" (ARG2),                             \
+                 [arg3] "g" (ARG3)                              \
+               : "ecx", "edx", "cc", "memory");                 \
           retval;                                               \
         })
 
@@ -182,3 +219,171 @@ inumber (int fd)
 {
   return syscall1 (SYS_INUMBER, fd);
 }
+
+bool
+set_rss_limit (int pages)
+{
+  return syscall1 (SYS_SET_RSS_LIMIT, pages);
+}
+
+int
+msync (void *addr, size_t length)
+{
+  return syscall2 (SYS_MSYNC, addr, length);
+}
+
+int
+madvise (void *addr, size_t length, int advice)
+{
+  return syscall3 (SYS_MADVISE, addr, length, advice);
+}
+
+bool
+ring_setup (struct syscall_ring *ring)
+{
+  return syscall1 (SYS_RING_SETUP, ring);
+}
+
+int
+ring_enter (void)
+{
+  return syscall0 (SYS_RING_ENTER);
+}
+
+int
+pread (int fd, void *buffer, unsigned length, int offset)
+{
+  return syscall4 (SYS_PREAD, fd, buffer, length, offset);
+}
+
+int
+pwrite (int fd, const void *buffer, unsigned length, int offset)
+{
+  return syscall4 (SYS_PWRITE, fd, buffer, length, offset);
+}
+
+int
+readv (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_READV, fd, iov, iovcnt);
+}
+
+int
+writev (int fd, const struct iovec *iov, int iovcnt)
+{
+  return syscall3 (SYS_WRITEV, fd, iov, iovcnt);
+}
+
+int
+copy_file_range (int in_fd, int out_fd, unsigned length)
+{
+  return syscall3 (SYS_COPY_FILE_RANGE, in_fd, out_fd, length);
+}
+
+int
+aio_read (int fd, void *buffer, unsigned length, int offset)
+{
+  return syscall4 (SYS_AIO_READ, fd, buffer, length, offset);
+}
+
+int
+aio_write (int fd, const void *buffer, unsigned length, int offset)
+{
+  return syscall4 (SYS_AIO_WRITE, fd, buffer, length, offset);
+}
+
+int
+aio_wait (int id)
+{
+  return syscall1 (SYS_AIO_WAIT, id);
+}
+
+int
+aio_poll (int id)
+{
+  return syscall1 (SYS_AIO_POLL, id);
+}
+
+bool
+pipe (int fds[2])
+{
+  return syscall1 (SYS_PIPE, fds);
+}
+
+int
+dup2 (int oldfd, int newfd)
+{
+  return syscall2 (SYS_DUP2, oldfd, newfd);
+}
+
+int
+poll (struct pollfd *fds, int nfds, int timeout)
+{
+  return syscall3 (SYS_POLL, fds, nfds, timeout);
+}
+
+int
+shm_open (const char *name, unsigned size)
+{
+  return syscall2 (SYS_SHM_OPEN, name, size);
+}
+
+/* A segment is mapped like a file. */
+mapid_t
+shm_map (int fd, void *addr)
+{
+  return mmap (fd, addr);
+}
+
+bool
+shm_unlink (const char *name)
+{
+  return syscall1 (SYS_SHM_UNLINK, name);
+}
+
+int
+futex_wait (int *addr, int val)
+{
+  return syscall2 (SYS_FUTEX_WAIT, addr, val);
+}
+
+int
+futex_wake (int *addr, int n)
+{
+  return syscall2 (SYS_FUTEX_WAKE, addr, n);
+}
+
+/* What a thread started by thread_spawn() runs, kept at the top of
+   its stack. */
+struct start_info
+  {
+    void (*entry) (void *);
+    void *arg;
+  };
+
+/* Runs the function of a new thread, then ends the thread. */
+static void
+start_thread (void *start_)
+{
+  struct start_info *start = start_;
+
+  start->entry (start->arg);
+  syscall0 (SYS_THREAD_EXIT);
+  NOT_REACHED ();
+}
+
+tid_t
+thread_spawn (void (*entry) (void *), void *arg, void *stack)
+{
+  struct start_info *start = (struct start_info *) stack - 1;
+
+  start->entry = entry;
+  start->arg = arg;
+  return syscall3 (SYS_THREAD_SPAWN, start_thread, start, start);
+}
+
+int
+thread_join (tid_t tid)
+{
+  return syscall1 (SYS_THREAD_JOIN, tid);
+}
@@ -2,7 +2,9 @@
 #define __LIB_USER_SYSCALL_H
 
 #include <stdbool.h>
+#include <stddef.h>
 #include <debug.h>
+#include <syscall-ring.h>
 #include "threads/thread.h"
 
 /* Process identifier. */
@@ -13,6 +15,49 @@ typedef int pid_t;
 /* Maximum characters in a filename written by readdir(). */
 #define READDIR_MAX_LEN 14
 
+/* True if system calls enter the kernel with SYSENTER rather than
+   "int $0x30".  Set at startup if the CPU supports SYSENTER; a
+   program may clear it to use "int $0x30" anyway. */
+extern bool syscall_sysenter;
+
+/* A buffer for readv() and writev(). */
+struct iovec
+  {
+    void *iov_base;             /* Start of the buffer. */
+    size_t iov_len;             /* Its length in bytes. */
+  };
+
+/* Maximum number of buffers for readv() and writev(). */
+#define IOV_MAX 16
+
+/* Returned by aio_poll() for a request still in progress. */
+#define AIO_PENDING (-2)
+
+/* An fd to watch with poll(). */
+struct pollfd
+  {
+    int fd;                     /* File descriptor, or aio id. */
+    short events;               /* Events to watch for. */
+    short revents;              /* Events that happened. */
+  };
+
+/* poll() events. */
+#define POLLIN   0x001          /* Reading would not wait. */
+#define POLLOUT  0x004          /* Writing would not wait. */
+#define POLLNVAL 0x020          /* FD is not open. */
+#define POLLAIO  0x100          /* FD is an aio id, and the I/O finished. */
+
+/* Maximum number of fds for poll(). */
+#define POLL_MAX 64
+
+/* Hints given to madvise(). */
+#define MADV_NORMAL     0       /* No special treatment. */
+#define MADV_RANDOM     1       /* Expect random accesses, no read-ahead. */
+#define MADV_SEQUENTIAL 2       /* Expect sequential accesses. */
+#define MADV_WILLNEED   3       /* Expect access soon, page in now. */
+#define MADV_DONTNEED   4       /* Not needed soon, page out now,
+                                   keeping the data. */
+
 /* Typical return values from main() and arguments to exit(). */
 #define EXIT_SUCCESS 0          /* Successful execution. */
 #define EXIT_FAILURE 1          /* Unsuccessful execution. */
@@ -43,4 +88,30 @@ bool readdir (int fd, char name[READDIR_MAX_LEN + 1]);
 bool isdir (int fd);
 int inumber (int fd);
 
+/* Extensions. */
+bool set_rss_limit (int pages);
+int msync (void *addr, size_t length);
+int madvise (void *addr, size_t length, int advice);
+bool ring_setup (struct syscall_ring *ring);
+int ring_enter (void);
+int pread (int fd, void *buffer, unsigned length, int offset);
+int pwrite (int fd, const void *buffer, unsigned length, int offset);
+int readv (int fd, const struct iovec *iov, int iovcnt);
+int writev (int fd, const struct iovec *iov, int iovcnt);
+int copy_file_range (int in_fd, int out_fd, unsigned length);
+int aio_read (int fd, void *buffer, unsigned length, int offset);
+int aio_write (int fd, const void *buffer, unsigned length, int offset);
+int aio_wait (int id);
+int aio_poll (int id);
+bool pipe (int fds[2]);
+int dup2 (int oldfd, int newfd);
+int poll (struct pollfd *fds, int nfds, int timeout);
+int shm_open (const char *name, unsigned size);
+mapid_t shm_map (int fd, void *addr);
+bool shm_unlink (const char *name);
+int futex_wait (int *addr, int val);
+int futex_wake (int *addr, int n);
+tid_t thread_spawn (void (*entry) (void *), void *arg, void *stack);
+int thread_join (tid_t tid);
+
 #endif /* lib/user/syscall.h */
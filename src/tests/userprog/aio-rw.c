@@ -0,0 +1,43 @@
+/* Writes a file with aio_write(), reads it back with aio_read() while
+   computing, and collects the requests with aio_wait() and
+   aio_poll(). */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char data[1024];
+static char buf[1024];
+
+void
+test_main (void)
+{
+  int fd, id, result;
+  unsigned polls = 0;
+  size_t i;
+
+  for (i = 0; i < sizeof data; i++)
+    data[i] = i % 251;
+
+  CHECK (create ("data", sizeof data), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+
+  CHECK ((id = aio_write (fd, data, sizeof data, 0)) >= 0, "aio_write");
+  CHECK (aio_wait (id) == sizeof data, "aio_wait");
+  CHECK (aio_wait (id) == -1, "aio_wait again");
+
+  CHECK ((id = aio_read (fd, buf, sizeof buf, 0)) >= 0, "aio_read");
+  while ((result = aio_poll (id)) == AIO_PENDING)
+    polls++;
+  if (result != sizeof buf)
+    fail ("aio_poll returned %d after %u polls", result, polls);
+  compare_bytes (buf, data, sizeof data, 0, "data");
+
+  CHECK (aio_read (fd, buf, sizeof buf, -1) == -1,
+         "aio_read at negative offset");
+  CHECK (aio_read (42, buf, sizeof buf, 0) == -1, "aio_read bad fd");
+
+  /* Left for exit to clean up. */
+  CHECK (aio_write (fd, data, sizeof data, 0) >= 0, "aio_write, not waited");
+}
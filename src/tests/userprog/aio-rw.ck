@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(aio-rw) begin
+(aio-rw) create "data"
+(aio-rw) open "data"
+(aio-rw) aio_write
+(aio-rw) aio_wait
+(aio-rw) aio_wait again
+(aio-rw) aio_read
+(aio-rw) aio_read at negative offset
+(aio-rw) aio_read bad fd
+(aio-rw) aio_write, not waited
+(aio-rw) end
+aio-rw: exit(0)
+EOF
+pass;
@@ -0,0 +1,30 @@
+/* Copies a file to another one and then to the console with
+   copy_file_range(), and checks the copy and the file positions. */
+
+#include <stdio.h>
+#include <syscall.h>
+#include "tests/userprog/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+void
+test_main (void)
+{
+  int in_fd, out_fd;
+
+  CHECK (create ("copy.txt", sizeof sample - 1), "create \"copy.txt\"");
+  CHECK ((in_fd = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((out_fd = open ("copy.txt")) > 1, "open \"copy.txt\"");
+
+  CHECK (copy_file_range (in_fd, out_fd, 100) == 100, "copy 100 bytes");
+  CHECK (copy_file_range (in_fd, out_fd, 100000) == sizeof sample - 101,
+         "copy the rest");
+  CHECK (copy_file_range (in_fd, out_fd, 100) == 0, "copy at end of file");
+  CHECK (tell (out_fd) == sizeof sample - 1, "tell \"copy.txt\"");
+  check_file ("copy.txt", sample, sizeof sample - 1);
+
+  seek (in_fd, 0);
+  CHECK (copy_file_range (in_fd, STDOUT_FILENO, 71) == 71,
+         "copy to the console");
+  CHECK (copy_file_range (in_fd, 42, 10) == -1, "copy to a bad fd");
+}
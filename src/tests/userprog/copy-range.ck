@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(copy-range) begin
+(copy-range) create "copy.txt"
+(copy-range) open "sample.txt"
+(copy-range) open "copy.txt"
+(copy-range) copy 100 bytes
+(copy-range) copy the rest
+(copy-range) copy at end of file
+(copy-range) tell "copy.txt"
+(copy-range) verified contents of "copy.txt"
+"Amazing Electronic Fact: If you scuffed your feet long enough without
+(copy-range) copy to the console
+(copy-range) copy to a bad fd
+(copy-range) end
+copy-range: exit(0)
+EOF
+pass;
@@ -0,0 +1,26 @@
+/* Opens the same file many times, past the first growth of the file
+   descriptor table, and checks that the lowest free fd is always
+   handed out. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define OPEN_CNT 200
+
+void
+test_main (void)
+{
+  int fd, i;
+
+  for (i = 0; i < OPEN_CNT; i++)
+    if ((fd = open ("sample.txt")) != i + 2)
+      fail ("open #%d returned %d instead of %d", i, fd, i + 2);
+  msg ("opened \"sample.txt\" %d times", OPEN_CNT);
+
+  close (100);
+  close (40);
+  CHECK (open ("sample.txt") == 40, "reopen lowest free fd");
+  CHECK (open ("sample.txt") == 100, "reopen next free fd");
+  CHECK (open ("sample.txt") == OPEN_CNT + 2, "open past the last fd");
+}
@@ -0,0 +1,14 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(open-many) begin
+(open-many) opened "sample.txt" 200 times
+(open-many) reopen lowest free fd
+(open-many) reopen next free fd
+(open-many) open past the last fd
+(open-many) end
+open-many: exit(0)
+EOF
+pass;
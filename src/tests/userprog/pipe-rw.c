@@ -0,0 +1,48 @@
+/* Passes data through a pipe, whole pages into a page aligned buffer
+   and odd sized pieces, redirects the console output into the pipe
+   with dup2(), and checks end of file and writes without readers. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 4096)
+
+static char data[SIZE] __attribute__ ((aligned (4096)));
+static char buf[SIZE] __attribute__ ((aligned (4096)));
+
+void
+test_main (void)
+{
+  int fds[2];
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    data[i] = i % 251;
+  memset (buf, 0, SIZE);
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (write (fds[1], data, SIZE) == SIZE, "write two pages");
+  CHECK (read (fds[0], buf, SIZE) == SIZE, "read two pages");
+  compare_bytes (buf, data, SIZE, 0, "pipe");
+
+  CHECK (write (fds[1], data, 100) == 100, "write 100 bytes");
+  CHECK (read (fds[0], buf, 30) == 30, "read 30 bytes");
+  CHECK (read (fds[0], buf + 30, SIZE) == 70, "read the other 70 bytes");
+  compare_bytes (buf, data, 100, 0, "pipe");
+
+  CHECK (dup2 (1, 10) == 10, "dup2 console to fd 10");
+  CHECK (dup2 (fds[1], 1) == 1, "dup2 pipe to fd 1");
+  write (1, "hello", 5);
+  dup2 (10, 1);
+  close (10);
+  CHECK (read (fds[0], buf, SIZE) == 5 && !memcmp (buf, "hello", 5),
+         "read what was written to fd 1");
+
+  close (fds[1]);
+  CHECK (read (fds[0], buf, SIZE) == 0, "read at end of file");
+  CHECK (pipe (fds), "pipe again");
+  close (fds[0]);
+  CHECK (write (fds[1], data, 10) == -1, "write without readers");
+}
@@ -0,0 +1,22 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pipe-rw) begin
+(pipe-rw) pipe
+(pipe-rw) write two pages
+(pipe-rw) read two pages
+(pipe-rw) write 100 bytes
+(pipe-rw) read 30 bytes
+(pipe-rw) read the other 70 bytes
+(pipe-rw) dup2 console to fd 10
+(pipe-rw) dup2 pipe to fd 1
+(pipe-rw) read what was written to fd 1
+(pipe-rw) read at end of file
+(pipe-rw) pipe again
+(pipe-rw) write without readers
+(pipe-rw) end
+pipe-rw: exit(0)
+EOF
+pass;
@@ -0,0 +1,48 @@
+/* Polls the ends of a pipe, a file, a closed fd and an aio request,
+   with and without timeouts. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char buf[512];
+
+void
+test_main (void)
+{
+  struct pollfd pfds[3];
+  int fds[2];
+  int fd, id;
+
+  CHECK (pipe (fds), "pipe");
+  CHECK (create ("data", sizeof buf), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+
+  pfds[0].fd = fds[0];
+  pfds[0].events = POLLIN;
+  CHECK (poll (pfds, 1, 0) == 0 && pfds[0].revents == 0,
+         "poll empty pipe");
+  CHECK (poll (pfds, 1, 50) == 0 && pfds[0].revents == 0,
+         "poll empty pipe for 50 ms");
+
+  write (fds[1], "x", 1);
+  pfds[1].fd = fds[1];
+  pfds[1].events = POLLOUT;
+  pfds[2].fd = fd;
+  pfds[2].events = POLLIN | POLLOUT;
+  CHECK (poll (pfds, 3, -1) == 3, "poll pipe and file");
+  CHECK (pfds[0].revents == POLLIN, "read end is readable");
+  CHECK (pfds[1].revents == POLLOUT, "write end is writable");
+  CHECK (pfds[2].revents == (POLLIN | POLLOUT), "file is ready");
+
+  pfds[0].fd = 42;
+  CHECK (poll (pfds, 1, 0) == 1 && pfds[0].revents == POLLNVAL,
+         "poll closed fd");
+
+  CHECK ((id = aio_write (fd, buf, sizeof buf, 0)) >= 0, "aio_write");
+  pfds[0].fd = id;
+  pfds[0].events = POLLAIO;
+  CHECK (poll (pfds, 1, -1) == 1 && pfds[0].revents == POLLAIO,
+         "poll aio request");
+  CHECK (aio_wait (id) == sizeof buf, "aio_wait");
+}
@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(poll-pipe) begin
+(poll-pipe) pipe
+(poll-pipe) create "data"
+(poll-pipe) open "data"
+(poll-pipe) poll empty pipe
+(poll-pipe) poll empty pipe for 50 ms
+(poll-pipe) poll pipe and file
+(poll-pipe) read end is readable
+(poll-pipe) write end is writable
+(poll-pipe) file is ready
+(poll-pipe) poll closed fd
+(poll-pipe) aio_write
+(poll-pipe) poll aio request
+(poll-pipe) aio_wait
+(poll-pipe) end
+poll-pipe: exit(0)
+EOF
+pass;
@@ -0,0 +1,54 @@
+/* Writes a file with writev(), reads pieces of it back with
+   pread() and readv(), overwrites part of it with pwrite(), and
+   checks that the positional calls leave the file position alone. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static char data[1024];
+static char buf[1024];
+
+void
+test_main (void)
+{
+  struct iovec iov[3];
+  int fd;
+  size_t i;
+
+  for (i = 0; i < sizeof data; i++)
+    data[i] = i % 251;
+
+  CHECK (create ("data", sizeof data), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+
+  iov[0].iov_base = data;
+  iov[0].iov_len = 100;
+  iov[1].iov_base = data + 100;
+  iov[1].iov_len = 0;
+  iov[2].iov_base = data + 100;
+  iov[2].iov_len = sizeof data - 100;
+  CHECK (writev (fd, iov, 3) == sizeof data, "writev");
+  CHECK (tell (fd) == sizeof data, "tell after writev");
+
+  CHECK (pread (fd, buf, 300, 200) == 300, "pread");
+  compare_bytes (buf, data + 200, 300, 200, "data");
+  CHECK (tell (fd) == sizeof data, "tell after pread");
+
+  memset (buf, 0x5a, 10);
+  CHECK (pwrite (fd, buf, 10, 500) == 10, "pwrite");
+  memset (data + 500, 0x5a, 10);
+  CHECK (tell (fd) == sizeof data, "tell after pwrite");
+
+  seek (fd, 0);
+  iov[0].iov_base = buf;
+  iov[0].iov_len = 700;
+  iov[1].iov_base = buf + 700;
+  iov[1].iov_len = 1000;
+  CHECK (readv (fd, iov, 2) == sizeof data, "readv");
+  compare_bytes (buf, data, sizeof data, 0, "data");
+
+  CHECK (pread (fd, buf, 16, -1) == -1, "pread at negative offset");
+  CHECK (readv (fd, iov, IOV_MAX + 1) == -1, "readv too many buffers");
+}
@@ -0,0 +1,21 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(pread-writev) begin
+(pread-writev) create "data"
+(pread-writev) open "data"
+(pread-writev) writev
+(pread-writev) tell after writev
+(pread-writev) pread
+(pread-writev) tell after pread
+(pread-writev) pwrite
+(pread-writev) tell after pwrite
+(pread-writev) readv
+(pread-writev) pread at negative offset
+(pread-writev) readv too many buffers
+(pread-writev) end
+pread-writev: exit(0)
+EOF
+pass;
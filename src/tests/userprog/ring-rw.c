@@ -0,0 +1,70 @@
+/* Queues writes, a seek and a read on a system call ring, carries
+   them out with a single ring_enter(), and checks the completions
+   and the data read back. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+static struct syscall_ring ring;
+static char data[1024];
+static char buf[1024];
+
+/* Queues a request on the ring. */
+static void
+submit (int op, int fd, void *buffer, unsigned length, unsigned user_data)
+{
+  struct ring_sqe *sqe = &ring.sq[ring.sq_tail % RING_ENTRIES];
+  sqe->op = op;
+  sqe->fd = fd;
+  sqe->buffer = buffer;
+  sqe->length = length;
+  sqe->user_data = user_data;
+  ring.sq_tail++;
+}
+
+/* Reaps the next completion and checks it. */
+static void
+reap (unsigned user_data, int result)
+{
+  struct ring_cqe *cqe;
+
+  if (ring.cq_head == ring.cq_tail)
+    fail ("completion %u missing", user_data);
+  cqe = &ring.cq[ring.cq_head % RING_ENTRIES];
+  if (cqe->user_data != user_data || cqe->result != result)
+    fail ("completion %u returned %d, expected completion %u returning %d",
+          cqe->user_data, cqe->result, user_data, result);
+  ring.cq_head++;
+}
+
+void
+test_main (void)
+{
+  int fd;
+  size_t i;
+
+  for (i = 0; i < sizeof data; i++)
+    data[i] = i % 251;
+
+  CHECK (create ("data", sizeof data), "create \"data\"");
+  CHECK ((fd = open ("data")) > 1, "open \"data\"");
+  CHECK (ring_setup (&ring), "ring_setup");
+
+  submit (RING_WRITE, fd, data, 512, 1);
+  submit (RING_WRITE, fd, data + 512, 512, 2);
+  submit (RING_SEEK, fd, NULL, 0, 3);
+  submit (RING_READ, fd, buf, sizeof buf, 4);
+  submit (RING_READ, fd, (void *) 0xc0000000, 16, 5);
+  CHECK (ring_enter () == 5, "ring_enter");
+
+  reap (1, 512);
+  reap (2, 512);
+  reap (3, 0);
+  reap (4, sizeof buf);
+  reap (5, -1);
+  if (memcmp (buf, data, sizeof buf))
+    fail ("data read back differs from data written");
+  CHECK (ring_enter () == 0, "ring_enter with no requests");
+}
@@ -0,0 +1,15 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(ring-rw) begin
+(ring-rw) create "data"
+(ring-rw) open "data"
+(ring-rw) ring_setup
+(ring-rw) ring_enter
+(ring-rw) ring_enter with no requests
+(ring-rw) end
+ring-rw: exit(0)
+EOF
+pass;
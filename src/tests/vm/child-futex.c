@@ -0,0 +1,27 @@
+/* Child process of futex-shm.
+   Increments the counter in the segment of futex-shm, then waits
+   until futex-shm is done with it. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/futex-shm.inc"
+
+#define ACTUAL ((struct futex_shm *) 0x20000000)
+
+void
+test_main (void)
+{
+  struct futex_shm *s = ACTUAL;
+  int fd;
+
+  CHECK ((fd = shm_open ("futex", 0)) > 1, "shm_open \"futex\"");
+  CHECK (shm_map (fd, ACTUAL) != MAP_FAILED, "shm_map \"futex\"");
+  increment_counter (s);
+
+  mutex_lock (&s->lock);
+  while (!s->ready)
+    condvar_wait (&s->cond, &s->lock);
+  s->replied = true;
+  mutex_unlock (&s->lock);
+}
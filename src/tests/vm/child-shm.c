@@ -0,0 +1,25 @@
+/* Child process of shm-share.
+   Maps the segment shm-share filled, checks its contents and
+   overwrites them. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 4096)
+#define ACTUAL ((char *) 0x20000000)
+
+void
+test_main (void)
+{
+  int fd;
+  size_t i;
+
+  CHECK ((fd = shm_open ("segment", 0)) > 1, "shm_open \"segment\"");
+  CHECK (shm_map (fd, ACTUAL) != MAP_FAILED, "shm_map \"segment\"");
+  for (i = 0; i < SIZE; i++)
+    if (ACTUAL[i] != (char) (i % 251))
+      fail ("byte %zu is %d, should be %d", i, ACTUAL[i], (int) (i % 251));
+  memset (ACTUAL, 'x', SIZE);
+}
@@ -0,0 +1,25 @@
+/* Child process of page-churn.
+   Dirties 512 kB of memory, which is enough for a few of these
+   running together to push each other out to swap, then checks
+   that the data survived and exits without cleaning up. */
+
+#include "tests/lib.h"
+
+const char *test_name = "child-swap";
+
+#define SIZE (512 * 1024)
+static char buf[SIZE];
+
+int
+main (void)
+{
+  size_t i;
+
+  for (i = 0; i < SIZE; i += 256)
+    buf[i] = i / 256;
+  for (i = 0; i < SIZE; i += 256)
+    if (buf[i] != (char) (i / 256))
+      fail ("byte %zu is wrong", i);
+
+  return 0x42;
+}
@@ -0,0 +1,43 @@
+/* Runs child-futex, which increments a counter in a shared memory
+   segment concurrently with this process, with a mutex protecting
+   it, then waits on a condition variable for this process to finish.
+   Checks that no increment was lost. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+#include "tests/vm/futex-shm.inc"
+
+#define ACTUAL ((struct futex_shm *) 0x10000000)
+
+void
+test_main (void)
+{
+  struct futex_shm *s = ACTUAL;
+  pid_t child;
+  int fd;
+
+  CHECK ((fd = shm_open ("futex", 4096)) > 1, "shm_open \"futex\"");
+  CHECK (shm_map (fd, ACTUAL) != MAP_FAILED, "shm_map \"futex\"");
+  mutex_init (&s->lock);
+  condvar_init (&s->cond);
+  CHECK (futex_wait (&s->counter, 1) == -1, "futex_wait on a changed word");
+  CHECK (futex_wake (&s->counter, 1) == 0, "futex_wake without waiters");
+
+  quiet = true;
+  CHECK ((child = exec ("child-futex")) != -1, "exec \"child-futex\"");
+  increment_counter (s);
+  mutex_lock (&s->lock);
+  s->ready = true;
+  condvar_broadcast (&s->cond);
+  mutex_unlock (&s->lock);
+  CHECK (wait (child) == 0, "wait for child");
+  quiet = false;
+
+  if (s->counter != 2 * INCREMENTS)
+    fail ("counter is %d, should be %d", s->counter, 2 * INCREMENTS);
+  msg ("no increment lost");
+  if (!s->replied)
+    fail ("child did not see the broadcast");
+  msg ("child saw the broadcast");
+}
@@ -0,0 +1,19 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(futex-shm) begin
+(futex-shm) shm_open "futex"
+(futex-shm) shm_map "futex"
+(futex-shm) futex_wait on a changed word
+(futex-shm) futex_wake without waiters
+(child-futex) begin
+(child-futex) shm_open "futex"
+(child-futex) shm_map "futex"
+(child-futex) end
+(futex-shm) no increment lost
+(futex-shm) child saw the broadcast
+(futex-shm) end
+EOF
+pass;
@@ -0,0 +1,62 @@
+/* Pages out anonymous and file mapping pages with MADV_DONTNEED and
+   verifies that touching them again brings back their data, then
+   checks that madvise rejects bad hints and bad ranges. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/vm/sample.inc"
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define PAGE_CNT 8
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_CNT][PAGE_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+  int handle;
+  mapid_t map;
+  size_t i, j;
+
+  for (i = 0; i < PAGE_CNT; i++)
+    memset (buf[i], 'a' + i, PAGE_SIZE);
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED) == 0,
+         "madvise anonymous pages MADV_DONTNEED");
+  for (i = 0; i < PAGE_CNT; i++)
+    for (j = 0; j < PAGE_SIZE; j++)
+      if (buf[i][j] != (char) ('a' + i))
+        fail ("byte %zu of page %zu is %d, should be %d",
+              j, i, buf[i][j], 'a' + i);
+  msg ("anonymous pages kept their data");
+
+  CHECK ((handle = open ("sample.txt")) > 1, "open \"sample.txt\"");
+  CHECK ((map = mmap (handle, ACTUAL)) != MAP_FAILED, "mmap \"sample.txt\"");
+  if (memcmp (ACTUAL, sample, strlen (sample)))
+    fail ("read of mmap'd file reported bad data");
+  CHECK (madvise (ACTUAL, PAGE_SIZE, MADV_DONTNEED) == 0,
+         "madvise \"sample.txt\" MADV_DONTNEED");
+  if (memcmp (ACTUAL, sample, strlen (sample)))
+    fail ("mapping lost data after MADV_DONTNEED");
+  msg ("mapped page kept its data");
+
+  CHECK (madvise (buf, sizeof buf, MADV_WILLNEED) == 0,
+         "madvise MADV_WILLNEED");
+  CHECK (madvise (buf, sizeof buf, MADV_SEQUENTIAL) == 0,
+         "madvise MADV_SEQUENTIAL");
+  CHECK (madvise (buf, sizeof buf, MADV_RANDOM) == 0, "madvise MADV_RANDOM");
+  CHECK (madvise (buf, sizeof buf, MADV_NORMAL) == 0, "madvise MADV_NORMAL");
+
+  CHECK (madvise (buf, sizeof buf, -1) == -1, "advice -1 must fail");
+  CHECK (madvise (buf, sizeof buf, MADV_DONTNEED + 1) == -1,
+         "advice past MADV_DONTNEED must fail");
+  CHECK (madvise (buf[0] + 1, PAGE_SIZE, MADV_NORMAL) == -1,
+         "misaligned range must fail");
+  CHECK (madvise (ACTUAL + PAGE_SIZE, PAGE_SIZE, MADV_NORMAL) == -1,
+         "unmapped range must fail");
+
+  munmap (map);
+  close (handle);
+}
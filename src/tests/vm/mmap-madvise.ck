@@ -0,0 +1,23 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-madvise) begin
+(mmap-madvise) madvise anonymous pages MADV_DONTNEED
+(mmap-madvise) anonymous pages kept their data
+(mmap-madvise) open "sample.txt"
+(mmap-madvise) mmap "sample.txt"
+(mmap-madvise) madvise "sample.txt" MADV_DONTNEED
+(mmap-madvise) mapped page kept its data
+(mmap-madvise) madvise MADV_WILLNEED
+(mmap-madvise) madvise MADV_SEQUENTIAL
+(mmap-madvise) madvise MADV_RANDOM
+(mmap-madvise) madvise MADV_NORMAL
+(mmap-madvise) advice -1 must fail
+(mmap-madvise) advice past MADV_DONTNEED must fail
+(mmap-madvise) misaligned range must fail
+(mmap-madvise) unmapped range must fail
+(mmap-madvise) end
+EOF
+pass;
@@ -0,0 +1,49 @@
+/* Writes to a file through a mapping and syncs it with msync, then
+   unmaps the pages with madvise so that reading them again faults
+   them back in, and verifies the data both through the mapping and
+   with the read system call. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define SIZE (3 * 4096)
+
+void
+test_main (void)
+{
+  static char buf[SIZE];
+  int handle;
+  mapid_t map;
+  size_t i;
+
+  for (i = 0; i < SIZE; i++)
+    buf[i] = i % 251;
+
+  CHECK (create ("data", SIZE), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  CHECK ((map = mmap (handle, ACTUAL)) != MAP_FAILED, "mmap \"data\"");
+  memcpy (ACTUAL, buf, SIZE);
+
+  CHECK (msync (ACTUAL, SIZE) == 0, "msync \"data\"");
+  CHECK (msync (ACTUAL + 1, 4096) == -1, "msync misaligned range must fail");
+  CHECK (msync (ACTUAL, SIZE + 4096) == -1,
+         "msync past the mapping must fail");
+
+  CHECK (madvise (ACTUAL, SIZE, MADV_DONTNEED) == 0,
+         "madvise \"data\" MADV_DONTNEED");
+  if (memcmp (ACTUAL, buf, SIZE))
+    fail ("mapping lost data after msync");
+
+  memset (buf, 0, SIZE);
+  CHECK (read (handle, buf, SIZE) == SIZE, "read \"data\"");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != (char) (i % 251))
+      fail ("byte %zu of \"data\" is %d, should be %d",
+            i, buf[i], (char) (i % 251));
+
+  munmap (map);
+  close (handle);
+}
@@ -0,0 +1,17 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-msync) begin
+(mmap-msync) create "data"
+(mmap-msync) open "data"
+(mmap-msync) mmap "data"
+(mmap-msync) msync "data"
+(mmap-msync) msync misaligned range must fail
+(mmap-msync) msync past the mapping must fail
+(mmap-msync) madvise "data" MADV_DONTNEED
+(mmap-msync) read "data"
+(mmap-msync) end
+EOF
+pass;
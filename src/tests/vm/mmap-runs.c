@@ -0,0 +1,53 @@
+/* Maps a file of several pages, the last one partial, and syncs it
+   so that every page is clean.  Then dirties a run of two pages, a
+   lone page and the partial last page, leaving clean pages between
+   them, unmaps the file and verifies its contents with the read
+   system call. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define ACTUAL ((char *) 0x10000000)
+#define PAGE_SIZE 4096
+#define SIZE (5 * PAGE_SIZE + PAGE_SIZE / 2)
+
+/* Pages dirtied after the msync. */
+static bool
+is_dirtied (size_t page)
+{
+  return page == 0 || page == 1 || page == 3 || page == 5;
+}
+
+void
+test_main (void)
+{
+  static char buf[SIZE];
+  int handle;
+  mapid_t map;
+  size_t i;
+
+  CHECK (create ("data", SIZE), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  CHECK ((map = mmap (handle, ACTUAL)) != MAP_FAILED, "mmap \"data\"");
+  memset (ACTUAL, 'c', SIZE);
+  CHECK (msync (ACTUAL, SIZE) == 0, "msync \"data\"");
+
+  msg ("dirty pages 0, 1, 3 and 5");
+  for (i = 0; i < SIZE; i++)
+    if (is_dirtied (i / PAGE_SIZE))
+      ACTUAL[i] = 'd';
+  munmap (map);
+
+  CHECK (read (handle, buf, SIZE) == SIZE, "read \"data\"");
+  for (i = 0; i < SIZE; i++)
+    {
+      char expected = is_dirtied (i / PAGE_SIZE) ? 'd' : 'c';
+      if (buf[i] != expected)
+        fail ("byte %zu of \"data\" is '%c', should be '%c'",
+              i, buf[i], expected);
+    }
+  msg ("file holds the written data");
+  close (handle);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(mmap-runs) begin
+(mmap-runs) create "data"
+(mmap-runs) open "data"
+(mmap-runs) mmap "data"
+(mmap-runs) msync "data"
+(mmap-runs) dirty pages 0, 1, 3 and 5
+(mmap-runs) read "data"
+(mmap-runs) file holds the written data
+(mmap-runs) end
+EOF
+pass;
@@ -0,0 +1,30 @@
+/* Runs CHILD_CNT children, BATCH_CNT at a time, each of which
+   uses enough memory that a batch has to swap.  The swap device
+   only holds a few batches, so if exiting processes did not give
+   back their swap slots and frames the kernel would run out long
+   before the last child. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 1024
+#define BATCH_CNT 8
+
+void
+test_main (void)
+{
+  pid_t children[BATCH_CNT];
+  int i, j;
+
+  for (i = 0; i < CHILD_CNT; i += BATCH_CNT)
+    {
+      for (j = 0; j < BATCH_CNT; j++)
+        if ((children[j] = exec ("child-swap")) == PID_ERROR)
+          fail ("exec \"child-swap\" #%d failed", i + j);
+      for (j = 0; j < BATCH_CNT; j++)
+        if (wait (children[j]) != 0x42)
+          fail ("wait for child #%d failed", i + j);
+    }
+  msg ("ran %d children", CHILD_CNT);
+}
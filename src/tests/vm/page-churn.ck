@@ -0,0 +1,10 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-churn) begin
+(page-churn) ran 1024 children
+(page-churn) end
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Runs 16 child-linear processes at once, which together need
+   more memory than the user pool and swap can hold.  The kernel
+   has to kill some of them to make room for the others, instead
+   of panicking. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define CHILD_CNT 16
+
+void
+test_main (void)
+{
+  pid_t children[CHILD_CNT];
+  int finished = 0, killed = 0;
+  int i;
+
+  for (i = 0; i < CHILD_CNT; i++)
+    if ((children[i] = exec ("child-linear")) == PID_ERROR)
+      fail ("exec \"child-linear\" #%d failed", i);
+
+  for (i = 0; i < CHILD_CNT; i++)
+    {
+      int status = wait (children[i]);
+      if (status == 0x42)
+        finished++;
+      else if (status == -1)
+        killed++;
+      else
+        fail ("child %d exited with status %d", i, status);
+    }
+
+  CHECK (killed > 0, "some children were killed");
+  CHECK (finished > 0, "the other children finished");
+}
@@ -0,0 +1,20 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+
+our ($test);
+my (@output) = read_text_file ("$test.output");
+
+common_checks ("run", @output);
+
+@output = get_core_output ("run", @output);
+fail "missing 'some children were killed' message\n"
+  unless grep ($_ eq '(page-overcommit) some children were killed', @output);
+fail "missing 'the other children finished' message\n"
+  unless grep ($_ eq '(page-overcommit) the other children finished', @output);
+fail "out-of-memory kill was not logged\n"
+  unless grep (/^Out of memory: killed process \d+ \(child-linear\)/, @output);
+fail "out-of-memory killer chose the parent\n"
+  if grep (/^Out of memory: killed process \d+ \(page-overcommit\)/, @output);
+pass;
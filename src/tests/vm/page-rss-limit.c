@@ -0,0 +1,35 @@
+/* Limits the process to a few resident pages, then fills and checks
+   many more pages than that, so that the process has to evict its
+   own pages to swap and bring them back. */
+
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define LIMIT 16
+#define PAGE_CNT 128
+#define PAGE_SIZE 4096
+
+static char buf[PAGE_CNT][PAGE_SIZE];
+
+void
+test_main (void)
+{
+  size_t i, j;
+
+  CHECK (set_rss_limit (LIMIT), "set_rss_limit (%d)", LIMIT);
+
+  msg ("fill %d pages", PAGE_CNT);
+  for (i = 0; i < PAGE_CNT; i++)
+    for (j = 0; j < PAGE_SIZE; j++)
+      buf[i][j] = i + j;
+
+  msg ("check %d pages", PAGE_CNT);
+  for (i = 0; i < PAGE_CNT; i++)
+    for (j = 0; j < PAGE_SIZE; j++)
+      if (buf[i][j] != (char) (i + j))
+        fail ("byte %zu of page %zu is %d, should be %d",
+              j, i, buf[i][j], (char) (i + j));
+
+  CHECK (!set_rss_limit (-1), "set_rss_limit (-1) must fail");
+}
@@ -0,0 +1,13 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(page-rss-limit) begin
+(page-rss-limit) set_rss_limit (16)
+(page-rss-limit) fill 128 pages
+(page-rss-limit) check 128 pages
+(page-rss-limit) set_rss_limit (-1) must fail
+(page-rss-limit) end
+EOF
+pass;
@@ -0,0 +1,51 @@
+/* Reads two whole pages of a file into a page aligned buffer, which
+   the kernel may map from its page cache instead of copying, then
+   checks that writes to the buffer and to the file do not show
+   through to each other. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 4096)
+
+static char buf[SIZE] __attribute__ ((aligned (4096)));
+static char check[SIZE];
+
+void
+test_main (void)
+{
+  int handle, writer;
+  size_t i;
+
+  CHECK (create ("data", SIZE), "create \"data\"");
+  CHECK ((handle = open ("data")) > 1, "open \"data\"");
+  memset (check, 'a', SIZE);
+  CHECK (write (handle, check, SIZE) == SIZE, "write \"data\"");
+  seek (handle, 0);
+
+  CHECK (read (handle, buf, SIZE) == SIZE, "read \"data\"");
+  if (memcmp (buf, check, SIZE))
+    fail ("read reported bad data");
+
+  /* Writing the buffer must not change the file. */
+  memset (buf, 'b', 4096);
+  seek (handle, 0);
+  CHECK (read (handle, check, SIZE) == SIZE, "read \"data\" again");
+  for (i = 0; i < SIZE; i++)
+    if (check[i] != 'a')
+      fail ("byte %zu of \"data\" is '%c', should be 'a'", i, check[i]);
+
+  /* Writing the file must not change the buffer. */
+  CHECK ((writer = open ("data")) > 1, "open \"data\" for writing");
+  memset (check, 'c', SIZE);
+  CHECK (write (writer, check, SIZE) == SIZE, "overwrite \"data\"");
+  for (i = 0; i < SIZE; i++)
+    if (buf[i] != (i < 4096 ? 'b' : 'a'))
+      fail ("byte %zu of buffer is '%c', should be '%c'",
+            i, buf[i], i < 4096 ? 'b' : 'a');
+
+  close (writer);
+  close (handle);
+}
@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(read-cow) begin
+(read-cow) create "data"
+(read-cow) open "data"
+(read-cow) write "data"
+(read-cow) read "data"
+(read-cow) read "data" again
+(read-cow) open "data" for writing
+(read-cow) overwrite "data"
+(read-cow) end
+EOF
+pass;
@@ -0,0 +1,36 @@
+/* Fills a shared memory segment, runs child-shm, which checks the
+   data through its own mapping of the segment and overwrites it, and
+   checks that the child's writes show through. */
+
+#include <string.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define SIZE (2 * 4096)
+#define ACTUAL ((char *) 0x10000000)
+
+void
+test_main (void)
+{
+  pid_t child;
+  int fd;
+  size_t i;
+
+  CHECK ((fd = shm_open ("segment", SIZE)) > 1, "shm_open \"segment\"");
+  CHECK (shm_map (fd, ACTUAL) != MAP_FAILED, "shm_map \"segment\"");
+  for (i = 0; i < SIZE; i++)
+    ACTUAL[i] = i % 251;
+
+  quiet = true;
+  CHECK ((child = exec ("child-shm")) != -1, "exec \"child-shm\"");
+  CHECK (wait (child) == 0, "wait for child");
+  quiet = false;
+
+  for (i = 0; i < SIZE; i++)
+    if (ACTUAL[i] != 'x')
+      fail ("byte %zu is %d, should be 'x'", i, ACTUAL[i]);
+  msg ("child's writes are visible");
+  CHECK (shm_unlink ("segment"), "shm_unlink \"segment\"");
+  CHECK (!shm_unlink ("segment"), "shm_unlink \"segment\" again");
+}
@@ -0,0 +1,18 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(shm-share) begin
+(shm-share) shm_open "segment"
+(shm-share) shm_map "segment"
+(child-shm) begin
+(child-shm) shm_open "segment"
+(child-shm) shm_map "segment"
+(child-shm) end
+(shm-share) child's writes are visible
+(shm-share) shm_unlink "segment"
+(shm-share) shm_unlink "segment" again
+(shm-share) end
+EOF
+pass;
@@ -0,0 +1,90 @@
+/* Spawns threads that increment a counter shared through the address
+   space under a mutex, plus one that blocks reading a pipe while the
+   main thread writes to it, joins them, and checks the results.
+   Finally exits while another thread is blocked reading the empty
+   pipe, whose write end the process itself holds, which must not keep
+   the process from exiting. */
+
+#include <string.h>
+#include <synch.h>
+#include <syscall.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define THREAD_CNT 4
+#define INCREMENTS 2000
+#define STACK_SIZE 4096
+
+static char stacks[THREAD_CNT + 2][STACK_SIZE];
+static struct mutex lock = MUTEX_INITIALIZER;
+static int counter;
+
+static int fds[2];
+static char received[16];
+
+static void
+increment (void *aux UNUSED)
+{
+  int i;
+
+  for (i = 0; i < INCREMENTS; i++)
+    {
+      mutex_lock (&lock);
+      counter++;
+      mutex_unlock (&lock);
+    }
+}
+
+static void
+receive (void *aux UNUSED)
+{
+  read (fds[0], received, sizeof received);
+}
+
+static volatile bool blocking;
+
+static void
+receive_forever (void *aux UNUSED)
+{
+  char c;
+
+  blocking = true;
+  read (fds[0], &c, 1);
+  fail ("read from the empty pipe returned");
+}
+
+void
+test_main (void)
+{
+  tid_t tids[THREAD_CNT];
+  tid_t reader;
+  int i;
+
+  CHECK (pipe (fds), "pipe");
+  CHECK ((reader = thread_spawn (receive, NULL,
+                                 stacks[THREAD_CNT] + STACK_SIZE))
+         != TID_ERROR, "spawn reader");
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK ((tids[i] = thread_spawn (increment, NULL, stacks[i] + STACK_SIZE))
+           != TID_ERROR, "spawn thread %d", i);
+
+  CHECK (write (fds[1], "hello, threads!", sizeof received)
+         == sizeof received, "write to pipe");
+  CHECK (thread_join (reader) == 0, "join reader");
+  if (strcmp (received, "hello, threads!"))
+    fail ("reader received \"%s\"", received);
+
+  for (i = 0; i < THREAD_CNT; i++)
+    CHECK (thread_join (tids[i]) == 0, "join thread %d", i);
+  CHECK (thread_join (tids[0]) == -1, "join thread 0 again");
+  if (counter != THREAD_CNT * INCREMENTS)
+    fail ("counter is %d, should be %d", counter, THREAD_CNT * INCREMENTS);
+  msg ("no increment lost");
+
+  CHECK (thread_spawn (receive_forever, NULL,
+                      stacks[THREAD_CNT + 1] + STACK_SIZE)
+         != TID_ERROR, "spawn reader of the empty pipe");
+  while (!blocking)
+    continue;
+  msg ("exit with the reader blocked");
+}
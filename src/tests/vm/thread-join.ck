@@ -0,0 +1,26 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected ([<<'EOF']);
+(thread-join) begin
+(thread-join) pipe
+(thread-join) spawn reader
+(thread-join) spawn thread 0
+(thread-join) spawn thread 1
+(thread-join) spawn thread 2
+(thread-join) spawn thread 3
+(thread-join) write to pipe
+(thread-join) join reader
+(thread-join) join thread 0
+(thread-join) join thread 1
+(thread-join) join thread 2
+(thread-join) join thread 3
+(thread-join) join thread 0 again
+(thread-join) no increment lost
+(thread-join) spawn reader of the empty pipe
+(thread-join) exit with the reader blocked
+(thread-join) end
+thread-join: exit(0)
+EOF
+pass;
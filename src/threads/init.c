@@ -15,6 +15,7 @@
 #include "devices/timer.h"
 #include "devices/vga.h"
 #include "devices/rtc.h"
+#include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/io.h"
 #include "threads/loader.h"
@@ -23,8 +24,11 @@
 #include "threads/pte.h"
 #include "threads/thread.h"
 #ifdef USERPROG
+#include "userprog/aio.h"
 #include "userprog/process.h"
+#include "userprog/ctxbench.h"
 #include "userprog/exception.h"
+#include "userprog/futex.h"
 #include "userprog/gdt.h"
 #include "userprog/syscall.h"
 #include "userprog/tss.h"
@@ -33,6 +37,10 @@
 #endif
 #ifdef VM
 #include "devices/swap.h"
+#include "vm/frame-table.h"
+#include "vm/same-page.h"
+#include "vm/page-cache.h"
+#include "vm/shm.h"
 #endif
 #ifdef FILESYS
 #include "devices/block.h"
@@ -123,6 +131,12 @@ main (void)
   serial_init_queue ();
   timer_calibrate ();
 
+#ifdef VM
+  /* File data goes through the page cache from the start. */
+  page_cache_init ();
+  shm_init ();
+#endif
+
 #ifdef FILESYS
   /* Initialize file system. */
   ide_init ();
@@ -130,9 +144,15 @@ main (void)
   filesys_init (format_filesys);
 #endif
 
+#ifdef USERPROG
+  aio_init ();
+  futex_init ();
+#endif
+
 #ifdef VM
   /* Initialise the swap disk */  
   swap_init ();
+  same_page_init ();
 #endif
 
   printf ("Boot complete.\n");
@@ -158,16 +178,46 @@ bss_init (void)
   memset (&_start_bss, 0, &_end_bss - &_start_bss);
 }
 
+/* Returns the feature flags reported in EDX by CPUID leaf 1. */
+uint32_t
+cpuid_features (void)
+{
+  uint32_t eax = 1, ebx, ecx, edx;
+  asm volatile ("cpuid" : "+a" (eax), "=b" (ebx), "=c" (ecx), "=d" (edx));
+  return edx;
+}
+
 /* Populates the base page directory and page table with the
    kernel virtual mapping, and then sets up the CPU to use the
    new page directory.  Points init_page_dir to the page
-   directory it creates. */
+   directory it creates.
+
+   If the CPU supports 4 MB pages, every 4 MB of RAM that does not
+   hold kernel text (which must stay read-only) is mapped with a
+   single large page, saving page tables and TLB entries.
+
+   Kernel mappings are the same in every page directory, so they
+   are marked global: if the CPU supports it, their TLB entries
+   then survive the CR3 reload of every process switch. */
 static void
 paging_init (void)
 {
   uint32_t *pd, *pt;
   size_t page;
   extern char _start, _end_kernel_text;
+  uint32_t features = cpuid_features ();
+  bool pse = (features & CPUID_PSE) != 0;
+
+  if (pse)
+    {
+      uint32_t cr4;
+      asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+      asm volatile ("movl %0, %%cr4" : : "r" (cr4 | CR4_PSE));
+    }
+#ifdef VM
+  else
+    large_user_pages = false;
+#endif
 
   pd = init_page_dir = palloc_get_page (PAL_ASSERT | PAL_ZERO);
   pt = NULL;
@@ -179,13 +229,21 @@ paging_init (void)
       size_t pte_idx = pt_no (vaddr);
       bool in_kernel_text = &_start <= vaddr && vaddr < &_end_kernel_text;
 
+      if (pse && pte_idx == 0 && page + LGPG_PAGES <= init_ram_pages
+          && (vaddr + LGPGSIZE <= &_start || vaddr >= &_end_kernel_text))
+        {
+          pd[pde_idx] = pde_create_large_kernel (vaddr, true) | PTE_G;
+          page += LGPG_PAGES - 1;
+          continue;
+        }
+
       if (pd[pde_idx] == 0)
         {
           pt = palloc_get_page (PAL_ASSERT | PAL_ZERO);
           pd[pde_idx] = pde_create (pt);
         }
 
-      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text);
+      pt[pte_idx] = pte_create_kernel (vaddr, !in_kernel_text) | PTE_G;
     }
 
   /* Store the physical address of the page directory into CR3
@@ -194,6 +252,15 @@ paging_init (void)
      to/from Control Registers" and [IA32-v3a] 3.7.5 "Base Address
      of the Page Directory". */
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (init_page_dir)));
+
+  /* Global pages must only be enabled once paging is on.  See
+     [IA32-v3a] 3.12 "Translation Lookaside Buffers (TLBs)". */
+  if (features & CPUID_PGE)
+    {
+      uint32_t cr4;
+      asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+      asm volatile ("movl %0, %%cr4" : : "r" (cr4 | CR4_PGE));
+    }
 }
 
 /* Breaks the kernel command line into words and returns them as
@@ -267,6 +334,18 @@ parse_options (char **argv)
 #ifdef USERPROG
       else if (!strcmp (name, "-ul"))
         user_page_limit = atoi (value);
+#endif
+#ifdef VM
+      else if (!strcmp (name, "-merge"))
+        same_page_enabled = true;
+      else if (!strcmp (name, "-lgpages"))
+        large_user_pages = true;
+      else if (!strcmp (name, "-stkchunk"))
+        {
+          stack_chunk_pages = value != NULL ? atoi (value) : 0;
+          if (stack_chunk_pages < 1)
+            PANIC ("-stkchunk needs a positive number of pages");
+        }
 #endif
       else
         PANIC ("unknown option `%s' (use -h for help)", name);
@@ -317,6 +396,9 @@ run_actions (char **argv)
   static const struct action actions[] = 
     {
       {"run", 2, run_task},
+#ifdef USERPROG
+      {"ctxbench", 1, ctxbench_run},
+#endif
 #ifdef FILESYS
       {"ls", 1, fsutil_ls},
       {"cat", 2, fsutil_cat},
@@ -362,6 +444,8 @@ usage (void)
           "\nAvailable actions:\n"
 #ifdef USERPROG
           "  run 'PROG [ARG...]' Run PROG and wait for it to complete.\n"
+          "  ctxbench           Time process switches with and without\n"
+          "                     global kernel pages.\n"
 #else
           "  run TEST           Run TEST.\n"
 #endif
@@ -389,6 +473,11 @@ usage (void)
           "  -mlfqs             Use multi-level feedback queue scheduler.\n"
 #ifdef USERPROG
           "  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+          "  -merge             Merge identical anonymous user pages.\n"
+          "  -lgpages           Map aligned 4 MB mmap regions with large pages.\n"
+          "  -stkchunk=N        Grow user stacks N pages beyond a fault.\n"
 #endif
           );
   shutdown_power_off ();
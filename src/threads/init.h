@@ -9,4 +9,6 @@
 /* Page directory with kernel mappings only. */
 extern uint32_t *init_page_dir;
 
+uint32_t cpuid_features (void);
+
 #endif /* threads/init.h */
@@ -102,6 +102,49 @@ palloc_get_multiple (enum palloc_flags flags, size_t page_cnt)
   return pages;
 }
 
+/* Obtains a group of PAGE_CNT contiguous free pages whose
+   physical address is a multiple of PAGE_CNT pages, as needed
+   for large page mappings.  PAGE_CNT must be a power of 2.
+   FLAGS are interpreted as by palloc_get_multiple(), except
+   that no attempt is made to evict anything: a null pointer is
+   returned if no suitably aligned run is free. */
+void *
+palloc_get_aligned (enum palloc_flags flags, size_t page_cnt)
+{
+  struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+  size_t pool_pages = bitmap_size (pool->used_map);
+  size_t page_idx;
+  void *pages = NULL;
+
+  ASSERT (page_cnt != 0 && (page_cnt & (page_cnt - 1)) == 0);
+
+  /* First index whose physical page number is aligned. */
+  page_idx = ROUND_UP (pg_no (pool->base), page_cnt) - pg_no (pool->base);
+
+  lock_acquire (&pool->lock);
+  for (; page_idx + page_cnt <= pool_pages; page_idx += page_cnt)
+    if (bitmap_none (pool->used_map, page_idx, page_cnt))
+      {
+        bitmap_set_multiple (pool->used_map, page_idx, page_cnt, true);
+        pages = pool->base + PGSIZE * page_idx;
+        break;
+      }
+  lock_release (&pool->lock);
+
+  if (pages != NULL)
+    {
+      if (flags & PAL_ZERO)
+        memset (pages, 0, PGSIZE * page_cnt);
+    }
+  else
+    {
+      if (flags & PAL_ASSERT)
+        PANIC ("palloc_get_aligned: out of pages");
+    }
+
+  return pages;
+}
+
 /* Obtains a single free page and returns its kernel virtual
    address.
    If PAL_USER is set, the page is obtained from the user pool,
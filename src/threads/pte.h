@@ -67,6 +67,16 @@ static inline uintptr_t pd_no (const void *va) {
 #define PTE_M 0x8               /* 1=in memory, 0=in swap disk (PTEs only) */
 #define PTE_A 0x20              /* 1=accessed, 0=not acccessed. */
 #define PTE_D 0x40              /* 1=dirty, 0=not dirty (PTEs only). */
+#define PTE_PS 0x80             /* 1=4 MB page, 0=page table (PDEs only). */
+#define PTE_G 0x100             /* 1=global, kept in TLB across CR3 loads. */
+
+/* Large pages.  With CR4.PSE enabled, a PDE that has PTE_PS set
+   maps a 4 MB aligned physical region directly, without a page
+   table, using a single TLB entry.  The dirty bit then lives in
+   the PDE. */
+#define LGPGSIZE PTSPAN                    /* Bytes in a large page. */
+#define LGPGMASK (LGPGSIZE - 1)            /* Large page offset bits. */
+#define LGPG_PAGES (LGPGSIZE / PGSIZE)     /* Pages in a large page. */
 
 /* Returns a PDE that points to page table PT. */
 static inline uint32_t pde_create (uint32_t *pt) {
@@ -104,5 +114,25 @@ static inline void *pte_get_page (uint32_t pte) {
   return ptov (pte & PTE_ADDR);
 }
 
+/* Returns a PDE that maps the 4 MB large page starting at PAGE.
+   If WRITABLE is true then it will be writable as well.
+   The page will be usable only by ring 0 code (the kernel). */
+static inline uint32_t pde_create_large_kernel (void *page, bool writable) {
+  ASSERT (((uintptr_t) page & LGPGMASK) == 0);
+  return vtop (page) | PTE_P | PTE_PS | (writable ? PTE_W : 0);
+}
+
+/* Returns a PDE that maps the 4 MB large page starting at PAGE.
+   The page will be usable by both user and kernel code. */
+static inline uint32_t pde_create_large_user (void *page, bool writable) {
+  return pde_create_large_kernel (page, writable) | PTE_U;
+}
+
+/* Returns a pointer to the large page that PDE points to. */
+static inline void *pde_get_large_page (uint32_t pde) {
+  ASSERT (pde & PTE_PS);
+  return ptov (pde & ~(uint32_t) LGPGMASK);
+}
+
 #endif /* threads/pte.h */
 
@@ -336,3 +336,87 @@ cond_broadcast (struct condition *cond, struct lock *lock)
   while (!list_empty (&cond->waiters))
     cond_signal (cond, lock);
 }
+
+/* Initializes wait queue Q. */
+void
+wait_queue_init (struct wait_queue *q)
+{
+  ASSERT (q != NULL);
+
+  list_init (&q->entries);
+}
+
+/* Adds ENTRY to Q, so that SEMA is upped every time Q is woken until
+   ENTRY is removed again.  Checking for the event after adding ENTRY,
+   and only then downing SEMA, cannot miss a wakeup. */
+void
+wait_queue_add (struct wait_queue *q, struct wait_entry *entry,
+                struct semaphore *sema)
+{
+  enum intr_level old_level;
+
+  ASSERT (q != NULL);
+  ASSERT (entry != NULL);
+  ASSERT (sema != NULL);
+
+  entry->sema = sema;
+  old_level = intr_disable ();
+  list_push_back (&q->entries, &entry->elem);
+  intr_set_level (old_level);
+}
+
+/* Removes ENTRY from the queue it was added to.  Does nothing if
+   ENTRY was never added, which its SEMA member being NULL tells, or
+   if wait_queue_destroy () removed it already. */
+void
+wait_queue_remove (struct wait_entry *entry)
+{
+  enum intr_level old_level;
+
+  ASSERT (entry != NULL);
+
+  old_level = intr_disable ();
+  if (entry->sema != NULL)
+    list_remove (&entry->elem);
+  entry->sema = NULL;
+  intr_set_level (old_level);
+}
+
+/* Ups the semaphore of every entry in Q.
+
+   This function may be called from an interrupt handler. */
+void
+wait_queue_wake (struct wait_queue *q)
+{
+  enum intr_level old_level;
+  struct list_elem *e;
+
+  ASSERT (q != NULL);
+
+  old_level = intr_disable ();
+  for (e = list_begin (&q->entries); e != list_end (&q->entries);
+       e = list_next (e))
+    sema_up (list_entry (e, struct wait_entry, elem)->sema);
+  intr_set_level (old_level);
+}
+
+/* Wakes and removes every entry of Q, which is about to be freed
+   while threads may still be waiting on it.  They find out that the
+   object Q belongs to is gone when they look at it again. */
+void
+wait_queue_destroy (struct wait_queue *q)
+{
+  enum intr_level old_level;
+
+  ASSERT (q != NULL);
+
+  old_level = intr_disable ();
+  while (!list_empty (&q->entries))
+    {
+      struct wait_entry *entry = list_entry (list_pop_front (&q->entries),
+                                             struct wait_entry, elem);
+      sema_up (entry->sema);
+      entry->sema = NULL;
+    }
+  intr_set_level (old_level);
+}
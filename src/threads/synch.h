@@ -41,6 +41,28 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+/* Wait queue.  Unlike a condition variable, it may be woken from an
+   interrupt handler, and a thread may wait on several queues at once
+   by adding an entry to each that ups the same semaphore. */
+struct wait_queue
+  {
+    struct list entries;        /* List of wait_entry elems. */
+  };
+
+/* One waiter on a wait queue. */
+struct wait_entry
+  {
+    struct semaphore *sema;     /* Upped when the queue is woken. */
+    struct list_elem elem;      /* List element. */
+  };
+
+void wait_queue_init (struct wait_queue *);
+void wait_queue_add (struct wait_queue *, struct wait_entry *,
+                     struct semaphore *);
+void wait_queue_remove (struct wait_entry *);
+void wait_queue_wake (struct wait_queue *);
+void wait_queue_destroy (struct wait_queue *);
+
 /* Optimization barrier.
 
    The compiler will not reorder operations across an
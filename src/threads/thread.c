@@ -74,6 +74,8 @@ static struct thread *running_thread (void);
 static struct thread *next_thread_to_run (void);
 static void init_child (struct child *, struct thread *);
 static void init_thread (struct thread *, const char *name, int priority);
+static tid_t create_thread (const char *name, int priority, thread_func *,
+                            void *aux, struct thread *process);
 static bool is_thread (struct thread *) UNUSED;
 static void *alloc_frame (struct thread *, size_t size);
 static void schedule (void);
@@ -203,6 +205,29 @@ mmap_hash_less (const struct hash_elem *a, const struct hash_elem *b, void *aux
 tid_t
 thread_create (const char *name, int priority,
                thread_func *function, void *aux) 
+{
+  return create_thread (name, priority, function, aux, NULL);
+}
+
+#ifdef USERPROG
+/* Like thread_create (), but the new thread belongs to the user
+   process of the running thread, sharing its address space and open
+   files, instead of starting a process of its own.  It must not exit
+   before it has left the process, see process_exit (). */
+tid_t
+thread_create_user (const char *name, int priority,
+                    thread_func *function, void *aux)
+{
+  return create_thread (name, priority, function, aux,
+                        thread_current ()->process);
+}
+#endif
+
+/* Creates a thread for thread_create (), or for
+   thread_create_user () if PROCESS is not NULL. */
+static tid_t
+create_thread (const char *name, int priority, thread_func *function,
+               void *aux, struct thread *process UNUSED)
 {
   struct thread *t;
   struct kernel_thread_frame *kf;
@@ -224,22 +249,35 @@ thread_create (const char *name, int priority,
   tid = t->tid = allocate_tid ();
 
 #ifdef USERPROG
-  struct child *child = malloc (sizeof (struct child));
-  if (child == NULL) {
-    palloc_free_page (t);
-    return TID_ERROR;
-  }
-  init_child (child, t);
-  t->child = child;
-
-  /* Add the new child process into the parent's child_list. */
-  list_push_back (&thread_current ()->child_list, &child->elem);
+  if (process != NULL) {
+    t->process = process;
+    t->pagedir = process->pagedir;
+    t->fd_table = process->fd_table;
+#ifdef VM
+    t->spt = process->spt;
 #endif
+  } else {
+    struct child *child = malloc (sizeof (struct child));
+    if (child == NULL) {
+      palloc_free_page (t);
+      return TID_ERROR;
+    }
+    init_child (child, t);
+    t->child = child;
+    t->parent = thread_current ()->process;
+
+    /* Add the new child process into the parent's child_list. */
+    list_push_back (&t->parent->child_list, &child->elem);
 
 #ifdef VM
-  hash_init (&t->mmapped_file_table, &mmap_hash_func, &mmap_hash_less, NULL);
-  t->spt = spt_create ();
-  t->next_mapid = 0;
+    hash_init (&t->mmapped_file_table, &mmap_hash_func, &mmap_hash_less,
+               NULL);
+    t->spt = spt_create ();
+    t->next_mapid = 0;
+    list_init (&t->frames);
+    t->rss_limit = t->parent->rss_limit;
+#endif
+  }
 #endif
 
   /* Prepare thread for first run by initializing its stack.
@@ -374,7 +412,11 @@ thread_exit (void)
 #endif
 
 #ifdef VM
-  spt_destroy (cur->spt);
+  if (cur->process == cur) {
+    spt_destroy (cur->spt);
+    cur->spt = NULL;
+    hash_destroy (&cur->mmapped_file_table, NULL);
+  }
 #endif
 
   cur->status = THREAD_DYING;
@@ -579,7 +621,16 @@ init_thread (struct thread *t, const char *name, int priority)
   t->magic = THREAD_MAGIC;
 
 #ifdef USERPROG
+  t->process = t;
   list_init (&t->child_list);
+  lock_init (&t->aio_lock);
+  list_init (&t->aio_requests);
+  list_init (&t->threads);
+  sema_init (&t->threads_exited, 0);
+  wait_queue_init (&t->exit_waiters);
+#endif
+#ifdef VM
+  lock_init (&t->vm_lock);
 #endif
 
   old_level = intr_disable ();
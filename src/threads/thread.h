@@ -39,7 +39,6 @@ typedef int tid_t;
 #define PRI_MIN 0                       /* Lowest priority. */
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
-#define MAX_OPEN_FILE 10                /* Maximum number of files opened. */
 #define MAX_STACK_SIZE (8 * 1024 * 1024) /* 8 MB */
 
 /* A kernel thread or user process.
@@ -112,21 +111,52 @@ struct thread
     struct list_elem elem;              /* List element. */
 
 #ifdef USERPROG
-    /* Owned by userprog/process.c. */
+    /* Owned by userprog/process.c.  A process is its main thread plus
+       the threads started by thread_create_user (), which share the
+       page directory, page table and open files of the main thread.
+       The main thread outlives them, and the members below marked
+       per-process are only used in it: PROCESS leads to them. */
+    struct thread *process;             /* Main thread of the process. */
+    struct user_thread *user_thread;    /* Join record, NULL in a main
+                                           thread. */
     uint32_t *pagedir;                  /* Page directory. */
-    struct file *fd_table[MAX_OPEN_FILE];  /* Mapping between file descriptors
-                                              and file pointers. */
+    struct fd_table *fd_table;          /* Open files, created with fds 0
+                                           and 1 by start_process (), shared
+                                           with the other threads. */
+
+    /* Per-process. */
     struct list child_list;             /* List for child threads. */
     struct child *child;                /* Points to its child structure. */
+    struct thread *parent;              /* Thread that created it. */
+    struct syscall_ring *ring;          /* Registered system call ring. */
+    struct lock aio_lock;               /* Protects the next two. */
+    struct list aio_requests;           /* Uncollected asynchronous I/O. */
+    int next_aio_id;                    /* Id of the next aio request. */
+    struct list threads;                /* struct user_thread of the other
+                                           threads, until joined. */
+    int thread_cnt;                     /* # of other threads running. */
+    struct semaphore threads_exited;    /* Upped as each of them exits. */
+    bool exiting;                       /* exit () was called. */
+    struct wait_queue exit_waiters;     /* Woken when exiting is set. */
 #endif
 
 #ifdef VM
     struct hash *spt;
     void *esp;
+
+    /* Per-process. */
+    struct lock vm_lock;                /* Serializes page faults and mapping
+                                           changes of the threads. */
     struct hash mmapped_file_table;
     int stack_size;
     mapid_t next_mapid;
     struct list_elem share_elem;
+    struct list frames;                 /* Frames owned, see frame-table.c. */
+    size_t resident_pages;              /* # of frames owned, not counting
+                                           page cache frames. */
+    size_t rss_limit;                   /* Max resident_pages, 0 if none. */
+    size_t swap_pages;                  /* # of pages in swap. */
+    bool oom_killed;                    /* Chosen by the out-of-memory killer. */
 #endif
 
     /* Owned by thread.c. */
@@ -149,6 +179,10 @@ void thread_print_stats (void);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
+#ifdef USERPROG
+tid_t thread_create_user (const char *name, int priority, thread_func *,
+                          void *);
+#endif
 
 void thread_block (void);
 void thread_unblock (struct thread *);
@@ -0,0 +1,221 @@
+#include "userprog/aio.h"
+#include <list.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/interrupt.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
+#include "../lib/user/syscall.h"
+
+/* An asynchronous read or write of a process.  The I/O worker
+   transfers the data between FILE and a kernel buffer, so that it
+   never touches the memory of the process; the data of a write is
+   copied in when the request is submitted, and the data of a read is
+   copied out when the process collects the request. */
+struct aio_request {
+  int id;                             /* Identifies it to the process. */
+  bool write;                         /* Write rather than read? */
+  struct file *file;                  /* Reopened, so close () is safe. */
+  void *buffer;                       /* User buffer of a read. */
+  void *data;                         /* Kernel copy of the data. */
+  unsigned length;                    /* Bytes to transfer. */
+  off_t offset;                       /* Position in FILE. */
+  int result;                         /* Bytes transferred. */
+  bool finished;                      /* Set by the worker when done. */
+  struct semaphore done;              /* Upped by the worker when done. */
+  struct wait_queue waiters;          /* Woken by the worker when done. */
+  struct list_elem queue_elem;        /* Element in the worker queue. */
+  struct list_elem elem;              /* Element in the process list,
+                                         until a thread collects it. */
+};
+
+/* Requests waiting for the I/O worker. */
+static struct list queue;
+static struct lock queue_lock;
+static struct semaphore queue_sema;   /* One up per queued request. */
+
+static void worker (void *aux UNUSED);
+static struct aio_request *find_request (int id);
+static void free_request (struct aio_request *r);
+
+/* Starts the I/O worker. */
+void
+aio_init (void)
+{
+  list_init (&queue);
+  lock_init (&queue_lock);
+  sema_init (&queue_sema, 0);
+  thread_create ("aio", PRI_DEFAULT, worker, NULL);
+}
+
+/* Queues a read of LENGTH bytes at OFFSET in FILE into the user
+   BUFFER, or a write of them from BUFFER if WRITE is true, and returns
+   at once.  Returns the id to collect the request with, or -1 if it
+   cannot be queued. */
+int
+aio_submit (struct file *file, bool write, void *buffer, unsigned length,
+            off_t offset)
+{
+  struct thread *cur = process_current ();
+
+  if (length > AIO_MAX_LENGTH || offset < 0)
+    return -1;
+
+  struct aio_request *r = malloc (sizeof *r);
+  if (r == NULL)
+    return -1;
+  r->data = length > 0 ? malloc (length) : NULL;
+  r->file = file_reopen (file);
+  if ((length > 0 && r->data == NULL) || r->file == NULL
+      || (write && !copy_from_user (r->data, buffer, length))) {
+    file_close (r->file);
+    free (r->data);
+    free (r);
+    return -1;
+  }
+
+  r->write = write;
+  r->buffer = buffer;
+  r->length = length;
+  r->offset = offset;
+  r->result = -1;
+  r->finished = false;
+  sema_init (&r->done, 0);
+  wait_queue_init (&r->waiters);
+  lock_acquire (&cur->aio_lock);
+  r->id = cur->next_aio_id++;
+  list_push_back (&cur->aio_requests, &r->elem);
+  lock_release (&cur->aio_lock);
+
+  lock_acquire (&queue_lock);
+  list_push_back (&queue, &r->queue_elem);
+  lock_release (&queue_lock);
+  sema_up (&queue_sema);
+  return r->id;
+}
+
+/* Collects request ID of the current process: returns the number of
+   bytes it transferred, or -1 if there is no such request or the data
+   read cannot be copied out.  If the request is still in progress,
+   waits for it if WAIT is true, or else returns AIO_PENDING and leaves
+   it to be collected later. */
+int
+aio_collect (int id, bool wait)
+{
+  struct thread *process = process_current ();
+
+  /* Take the request out of the list, so that no other thread of the
+     process collects it too. */
+  lock_acquire (&process->aio_lock);
+  struct aio_request *r = find_request (id);
+  if (r != NULL && !wait && !r->finished) {
+    lock_release (&process->aio_lock);
+    return AIO_PENDING;
+  }
+  if (r != NULL)
+    list_remove (&r->elem);
+  lock_release (&process->aio_lock);
+  if (r == NULL)
+    return -1;
+
+  sema_down (&r->done);
+
+  int result = r->result;
+  if (!r->write && result > 0 && !copy_to_user (r->buffer, r->data, result))
+    result = -1;
+  free_request (r);
+  return result;
+}
+
+/* Stores in *FINISHED whether request ID of the current process has
+   finished, so that aio_collect () would not wait.  If ENTRY is not
+   NULL, also adds it to the wait queue of the request, so that SEMA is
+   upped when it finishes or is collected by another thread.  Returns
+   false, changing nothing, if there is no such request. */
+bool
+aio_ready (int id, bool *finished, struct wait_entry *entry,
+           struct semaphore *sema)
+{
+  struct thread *process = process_current ();
+
+  lock_acquire (&process->aio_lock);
+  struct aio_request *r = find_request (id);
+  if (r != NULL) {
+    *finished = r->finished;
+    if (entry != NULL)
+      wait_queue_add (&r->waiters, entry, sema);
+  }
+  lock_release (&process->aio_lock);
+  return r != NULL;
+}
+
+/* Waits for every request of the current process and frees them,
+   without copying anything out. */
+void
+aio_release_all (void)
+{
+  struct list *requests = &process_current ()->aio_requests;
+
+  /* The other threads are gone, so nothing else uses the list. */
+  while (!list_empty (requests)) {
+    struct aio_request *r = list_entry (list_pop_front (requests),
+                                        struct aio_request, elem);
+    sema_down (&r->done);
+    free_request (r);
+  }
+}
+
+/* Kernel thread that carries out queued requests, oldest first. */
+static void
+worker (void *aux UNUSED)
+{
+  for (;;) {
+    sema_down (&queue_sema);
+    lock_acquire (&queue_lock);
+    struct aio_request *r = list_entry (list_pop_front (&queue),
+                                        struct aio_request, queue_elem);
+    lock_release (&queue_lock);
+
+    if (r->write)
+      r->result = file_write_at (r->file, r->data, r->length, r->offset);
+    else
+      r->result = file_read_at (r->file, r->data, r->length, r->offset);
+
+    /* R may be freed as soon as DONE is up, so up it last, and make
+       sure nothing runs in between. */
+    enum intr_level old_level = intr_disable ();
+    r->finished = true;
+    wait_queue_wake (&r->waiters);
+    sema_up (&r->done);
+    intr_set_level (old_level);
+  }
+}
+
+/* Returns request ID of the current process, or NULL if it has none.
+   Must hold the process's aio_lock. */
+static struct aio_request *
+find_request (int id)
+{
+  struct list *requests = &process_current ()->aio_requests;
+  struct list_elem *e;
+
+  for (e = list_begin (requests); e != list_end (requests); e = list_next (e)) {
+    struct aio_request *r = list_entry (e, struct aio_request, elem);
+    if (r->id == id)
+      return r;
+  }
+  return NULL;
+}
+
+/* Frees completed request R, which is no longer in its process's
+   list, waking poll () calls still watching it. */
+static void
+free_request (struct aio_request *r)
+{
+  wait_queue_destroy (&r->waiters);
+  file_close (r->file);
+  free (r->data);
+  free (r);
+}
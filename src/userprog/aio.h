@@ -0,0 +1,23 @@
+#ifndef USERPROG_AIO_H
+#define USERPROG_AIO_H
+
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct file;
+struct semaphore;
+struct wait_entry;
+
+/* Largest transfer of one asynchronous request, in bytes.  The data
+   sits in a kernel buffer until the request is collected. */
+#define AIO_MAX_LENGTH (16 * 4096)
+
+void aio_init (void);
+int aio_submit (struct file *file, bool write, void *buffer,
+                unsigned length, off_t offset);
+int aio_collect (int id, bool wait);
+bool aio_ready (int id, bool *finished, struct wait_entry *entry,
+                struct semaphore *sema);
+void aio_release_all (void);
+
+#endif /* userprog/aio.h */
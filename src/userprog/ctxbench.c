@@ -0,0 +1,143 @@
+#include "userprog/ctxbench.h"
+#include <debug.h>
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "userprog/pagedir.h"
+#include "userprog/process.h"
+#include "threads/flags.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Context-switch microbenchmark, run by the "ctxbench" action.
+
+   Two kernel threads, each with its own page directory, hand a
+   semaphore back and forth, so that every hand-off is a switch
+   between two address spaces that reloads CR3.  After each switch
+   a thread touches BENCH_PAGES kernel pages.  Their translations
+   survive the CR3 reload only if kernel pages are global, so the
+   benchmark is run once with CR4.PGE set and once with it clear. */
+
+#define BENCH_ROUNDS 10000      /* Hand-offs per thread. */
+#define BENCH_PAGES 64          /* Kernel pages touched per switch. */
+
+/* One of the two benchmark threads. */
+struct bench_side
+  {
+    struct semaphore *mine;     /* Downed before each round. */
+    struct semaphore *other;    /* Upped after each round. */
+    struct semaphore *done;     /* Upped when all rounds are over. */
+    uint8_t *pages;             /* Kernel pages to touch. */
+  };
+
+/* Reads the CPU's time-stamp counter. */
+static uint64_t
+rdtsc (void)
+{
+  uint32_t lo, hi;
+  asm volatile ("rdtsc" : "=a" (lo), "=d" (hi));
+  return ((uint64_t) hi << 32) | lo;
+}
+
+/* Returns the current value of CR4. */
+static uint32_t
+read_cr4 (void)
+{
+  uint32_t cr4;
+  asm volatile ("movl %%cr4, %0" : "=r" (cr4));
+  return cr4;
+}
+
+/* Sets or clears CR4.PGE.  Either way, this flushes the whole TLB,
+   global entries included. */
+static void
+set_global_pages (bool enable)
+{
+  uint32_t cr4 = read_cr4 ();
+  cr4 = enable ? cr4 | CR4_PGE : cr4 & ~CR4_PGE;
+  asm volatile ("movl %0, %%cr4" : : "r" (cr4) : "memory");
+}
+
+/* Body of a benchmark thread. */
+static void
+bench_thread (void *side_)
+{
+  struct bench_side *side = side_;
+  struct thread *cur = thread_current ();
+  uint32_t *pd = pagedir_create ();
+  int i, page;
+
+  /* Run in an address space of our own, like a user process. */
+  cur->pagedir = pd;
+  process_activate ();
+
+  for (i = 0; i < BENCH_ROUNDS; i++)
+    {
+      sema_down (side->mine);
+      for (page = 0; page < BENCH_PAGES; page++)
+        side->pages[page * PGSIZE] ^= 1;
+      sema_up (side->other);
+    }
+
+  cur->pagedir = NULL;
+  pagedir_activate (NULL);
+  pagedir_destroy (pd);
+  sema_up (side->done);
+}
+
+/* Runs the ping-pong with global kernel pages enabled or not, and
+   returns the average number of cycles per switch. */
+static uint64_t
+run_bench (bool global, uint8_t *pages)
+{
+  struct semaphore a, b, done;
+  struct bench_side side_a = { &a, &b, &done, pages };
+  struct bench_side side_b = { &b, &a, &done, pages };
+  uint64_t start, end;
+
+  sema_init (&a, 0);
+  sema_init (&b, 0);
+  sema_init (&done, 0);
+  set_global_pages (global);
+
+  thread_create ("bench-a", PRI_DEFAULT, bench_thread, &side_a);
+  thread_create ("bench-b", PRI_DEFAULT, bench_thread, &side_b);
+
+  start = rdtsc ();
+  sema_up (&a);
+  sema_down (&done);
+  sema_down (&done);
+  end = rdtsc ();
+
+  return (end - start) / (2 * BENCH_ROUNDS);
+}
+
+/* Runs the context-switch microbenchmark and prints the average
+   cost of a switch with and without global kernel pages. */
+void
+ctxbench_run (char **argv UNUSED)
+{
+  bool pge = (read_cr4 () & CR4_PGE) != 0;
+  uint8_t *pages = palloc_get_multiple (PAL_ZERO, BENCH_PAGES);
+
+  if (pages == NULL)
+    {
+      printf ("ctxbench: out of memory\n");
+      return;
+    }
+
+  printf ("ctxbench: %d switches touching %d kernel pages each\n",
+          2 * BENCH_ROUNDS, BENCH_PAGES);
+  printf ("ctxbench: %"PRIu64" cycles/switch without global pages\n",
+          run_bench (false, pages));
+  if (pge)
+    printf ("ctxbench: %"PRIu64" cycles/switch with global pages\n",
+            run_bench (true, pages));
+  else
+    printf ("ctxbench: CPU does not support global pages\n");
+
+  set_global_pages (pge);
+  palloc_free_multiple (pages, BENCH_PAGES);
+}
@@ -0,0 +1,6 @@
+#ifndef USERPROG_CTXBENCH_H
+#define USERPROG_CTXBENCH_H
+
+void ctxbench_run (char **argv);
+
+#endif /* userprog/ctxbench.h */
@@ -5,15 +5,30 @@
 #include <debug.h>
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
+#include "threads/malloc.h"
 #include "threads/thread.h"
 #include "threads/vaddr.h"
+#include "threads/pte.h"
 #include "filesys/file.h"
+#include "userprog/process.h"
 #include "userprog/syscall.h"
+#include "userprog/uaccess.h"
 #include "threads/thread.h"
 #include "vm/frame-table.h"
 #include "vm/spt.h"
+#include "vm/same-page.h"
+#include "vm/page-cache.h"
+#include "filesys/inode.h"
 #include "devices/swap.h"
 #include "filesys/filesys.h"
+#include "lib/user/syscall.h"
+
+/* Number of pages read ahead of a fault in a MADV_SEQUENTIAL range. */
+#define READ_AHEAD_PAGES 8
+
+/* Number of pages the stack grows by, beyond the faulting page.
+   Controlled by kernel command-line option "-stkchunk=N". */
+int stack_chunk_pages = 4;
 
 /* Number of page faults processed. */
 static long long page_fault_cnt;
@@ -21,6 +36,7 @@ static long long page_fault_cnt;
 static void kill (struct intr_frame *);
 static void page_fault (struct intr_frame *);
 static void print_page_fault (void *, bool, bool, bool);
+static bool fixup_fault (struct intr_frame *, bool);
 
 /* Registers handlers for interrupts that can be caused by user
    programs.
@@ -117,20 +133,172 @@ kill (struct intr_frame *f)
     }
 }
 
-static size_t
+/* Maps the file mapping page SPTE from the page cache. */
+static bool
 load_from_file (struct spte *spte)
 {
-  /* Allocate a free page */
-  void *kpage = allocate_user_page (spte->vaddr, true, true);
-  spte->value = kpage;
+  return page_cache_map (spte);
+}
+
+/* Loads the whole 4 MB aligned region around SPTE with a single large
+   page, if large user pages are enabled and every page of the region
+   belongs to the same, not yet loaded, file mapping.
+   Returns false if the caller should fall back to load_from_file (). */
+static bool
+load_large_from_file (struct spte *spte)
+{
+  struct thread *cur = thread_current ();
+  uint8_t *base = (uint8_t *) ((uintptr_t) spte->vaddr & ~LGPGMASK);
+  size_t base_ofs = spte->file_ofs - ((uint8_t *) spte->vaddr - base);
+
+  if (!large_user_pages || base == NULL
+      || !is_user_vaddr (base + LGPGSIZE - 1)
+      || spte->file_ofs < (size_t) ((uint8_t *) spte->vaddr - base))
+    return false;
+
+  for (size_t i = 0; i < LGPG_PAGES; i++) {
+    struct spte *e = spt_find (cur->spt, base + i * PGSIZE);
+    if (e == NULL || e->status != MMAP || e->file != spte->file
+        || e->file_ofs != base_ofs + i * PGSIZE || e->value != NULL)
+      return false;
+  }
+
+  struct inode *inode = file_get_inode (spte->file);
+  uint8_t *kpage = page_cache_map_large (inode, base_ofs, base, true);
+  if (kpage == NULL)
+    return false;
+
+  off_t bytes = inode_length (inode) - (off_t) base_ofs;
+  for (size_t i = 0; i < LGPG_PAGES; i++) {
+    struct spte *e = spt_find (cur->spt, base + i * PGSIZE);
+    off_t page_start = i * PGSIZE;
+    e->value = kpage + page_start;
+    if (bytes <= page_start)
+      e->bytes_read = 0;
+    else if (bytes - page_start < PGSIZE)
+      e->bytes_read = bytes - page_start;
+    else
+      e->bytes_read = PGSIZE;
+  }
+  return true;
+}
 
-  /* Writes PGSIZE bytes from the mmapped file at file_ofs to kpage */
-  lock_acquire (&filesys_lock);
-  file_seek (spte->file, spte->file_ofs);
-  spte->bytes_read = file_read (spte->file, kpage, spte->read_bytes);
-  lock_release (&filesys_lock);
+/* Brings the page described by SPTE, a file mapping page or a page
+   in swap, into memory for the current process. Returns true if it
+   already was. Returns false if SPTE cannot be paged in, or if no
+   frame could be found for it. */
+bool
+page_in (struct spte *spte)
+{
+  if (spte->status == MMAP) {
+    if (spte->value != NULL)
+      return true;
+    if (spte->advice != MADV_RANDOM && load_large_from_file (spte))
+      return true;
+    return load_from_file (spte);
+  }
 
-  return spte->bytes_read;
+  if (spte->status != SWAP)
+    return false;
+  int swap_slot = (int) spte->value;
+  void *new_page = allocate_user_page (spte->vaddr, true, true);
+  if (new_page == NULL)
+    return false;
+  swap_in (spte->vaddr, swap_slot);
+  process_current ()->swap_pages--;
+  spte->status = FRAME;
+  spte->value = new_page;
+  return true;
+}
+
+/* Pages in the file mapping pages following SPTE, which is in a
+   MADV_SEQUENTIAL range. They are marked as not recently used, so
+   that the clock reclaims them first if they are not touched. */
+static void
+read_ahead (struct spte *spte)
+{
+  struct thread *cur = thread_current ();
+
+  for (int i = 1; i <= READ_AHEAD_PAGES; i++) {
+    struct spte *next = spt_find (cur->spt, spte->vaddr + i * PGSIZE);
+    if (next == NULL || next->status != MMAP || next->file != spte->file
+        || next->value != NULL)
+      break;
+    if (!load_from_file (next))
+      break;
+    frame_set_referenced (next->value, false);
+  }
+}
+
+/* Returns true if FAULT_ADDR looks like an access to the stack of a
+   process whose stack pointer is ESP. PUSHA writes 32 bytes below the
+   stack pointer before moving it, and a function with a large frame
+   lowers the stack pointer first and touches any part of the frame
+   afterwards, so anything from ESP - 32 up to the top of the stack
+   counts, as long as it is within MAX_STACK_SIZE of PHYS_BASE. */
+static bool
+is_stack_access (void *fault_addr, void *esp)
+{
+  return is_user_vaddr (fault_addr)
+         && (uint8_t *) fault_addr >= (uint8_t *) PHYS_BASE - MAX_STACK_SIZE
+         && (uint8_t *) fault_addr >= (uint8_t *) esp - 32;
+}
+
+/* Adds FAULT_PAGE to the stack of the current process, together with
+   every page between it and the current bottom of the stack and
+   stack_chunk_pages more below the old bottom, so that a deep call
+   chain does not fault on every single page. The pages are recorded
+   in the SPT like any other anonymous page, so they can be swapped
+   out. Pages below FAULT_PAGE are only allocated if memory and the
+   stack limit allow. Returns false if FAULT_PAGE could not be added. */
+static bool
+grow_stack (uint8_t *fault_page)
+{
+  struct thread *cur = process_current ();
+  uint8_t *limit = (uint8_t *) PHYS_BASE - MAX_STACK_SIZE;
+  uint8_t *bottom = (uint8_t *) PHYS_BASE - cur->stack_size;
+  uint8_t *new_bottom;
+
+  if (fault_page >= bottom) {
+    /* A hole in the stack, left by a mapping that is gone now. */
+    bottom = fault_page + PGSIZE;
+    new_bottom = fault_page;
+  } else if ((size_t) (bottom - limit) / PGSIZE > (size_t) stack_chunk_pages)
+    new_bottom = bottom - stack_chunk_pages * PGSIZE;
+  else
+    new_bottom = limit;
+  if (new_bottom > fault_page)
+    new_bottom = fault_page;
+
+  for (uint8_t *upage = bottom - PGSIZE; upage >= new_bottom;
+       upage -= PGSIZE) {
+    if (spt_find (cur->spt, upage) != NULL) {
+      /* Something else is mapped here. */
+      if (upage < fault_page)
+        break;
+      continue;
+    }
+
+    struct spte *spte = new_spte (upage);
+    if (spte == NULL)
+      return upage < fault_page;
+    void *kpage = allocate_user_page (upage, true, true);
+    if (kpage == NULL) {
+      lock_acquire (&spt_lock);
+      spt_remove_entry (cur->spt, &spte->elem);
+      lock_release (&spt_lock);
+      free (spte);
+      return upage < fault_page;
+    }
+    lock_acquire (&spt_lock);
+    spte->status = FRAME;
+    spte->value = kpage;
+    lock_release (&spt_lock);
+
+    if (cur->stack_size < (uint8_t *) PHYS_BASE - upage)
+      cur->stack_size = (uint8_t *) PHYS_BASE - upage;
+  }
+  return true;
 }
 
 /* Page fault handler.  This is a skeleton that must be filled in
@@ -174,73 +342,64 @@ page_fault (struct intr_frame *f)
   user = (f->error_code & PF_U) != 0;
 
   if (fault_addr == 0) {
+    if (fixup_fault (f, user))
+      return;
     kill (f);
   }
 
   struct thread *cur = thread_current ();
   void *fault_page = pg_round_down (fault_addr);
-  void *user_esp = thread_current ()->esp;
-  void *u_esp = user ? f->esp : user_esp;
-
-  if (fault_addr <= u_esp && fault_addr > u_esp - PGSIZE) {
-
-    /* Is a stack access */
+  bool resolved = false;
+  bool true_fault = false;
+
+  /* Keep the other threads of the process from bringing in the same
+     page, or changing the mappings, at the same time. */
+  lock_acquire (&cur->process->vm_lock);
+  if (!not_present) {
+    /* Writing a merged page, or a cached page mapped by read (),
+       breaks the sharing, anything else is a rights violation. */
     struct spte *spte = spt_find (cur->spt, fault_page);
-    if (spte != NULL) {
-
-      /* In swap */
-      ASSERT (spte->status == SWAP);
-      int swap_slot = (int) spte->value;
-      swap_in (fault_page, swap_slot);
-
-    } else {
-
-      /* Not in swap, implement stack growth */
-      if (cur->stack_size < MAX_STACK_SIZE) {
-        cur->stack_size += PGSIZE;
-        // cur->esp += PGSIZE;
-
-        /* Allocate a consecutive page for the stack */
-        void *new_page = allocate_user_page (PHYS_BASE - cur->stack_size,
-                                             true, true);
-        struct spte *spte = new_spte (PHYS_BASE - cur->stack_size);
-        lock_acquire (&spt_lock);
-        spte->value = new_page;
-        spte->status = FRAME;
-        lock_release (&spt_lock);
-
-      } else {
-        /* Stack size too big, terminate the process */
-        exit (-1);
-      }
-    }
-
+    resolved = write && spte != NULL
+               && ((spte->is_shared && same_page_break (spte))
+                   || (spte->cow != NULL && page_cache_break_cow (spte)));
   } else {
-
+    void *u_esp = user ? f->esp : cur->esp;
     struct spte *spte = spt_find (cur->spt, fault_page);
-
     if (spte != NULL) {
-      /* Lazy-loading */
-      if (spte->status == MMAP) {
-        /* MMAP */
-        load_from_file (spte);
-      } else {
-
-        if (spte->status != SWAP) {
-          exit (-1);
-        }
-        int swap_slot = (int) spte->value;
-        void *new_page = allocate_user_page (fault_page, true, true);
-        swap_in (fault_page, swap_slot);
-        spte->status = FRAME;
-        spte->value = new_page;
-        // /* Data demand-paged from  */
-      }
-    } else {
-      /* True page fault */
-      print_page_fault (fault_addr, not_present, write, user);
-    }
+      /* Lazy-loading from the mapped file or from swap */
+      resolved = page_in (spte);
+      if (resolved && spte->status == MMAP
+          && spte->advice == MADV_SEQUENTIAL)
+        read_ahead (spte);
+    } else if (is_stack_access (fault_addr, u_esp))
+      resolved = grow_stack (fault_page);
+    else
+      true_fault = true;
   }
+  lock_release (&cur->process->vm_lock);
+
+  if (resolved || fixup_fault (f, user))
+    return;
+  if (true_fault)
+    print_page_fault (fault_addr, not_present, write, user);
+  exit (-1);
+}
+
+/* If the kernel faulted on user memory in an instruction listed in
+   the exception table, makes it resume at the fixup code for that
+   instruction, which reports the error to its caller, and returns
+   true.  Returns false for any other fault. */
+static bool
+fixup_fault (struct intr_frame *f, bool user)
+{
+  if (user)
+    return false;
+
+  uintptr_t fixup = search_exception_table ((uintptr_t) f->eip);
+  if (fixup == 0)
+    return false;
+  f->eip = (void (*) (void)) fixup;
+  return true;
 }
 
 static void 
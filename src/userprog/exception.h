@@ -1,12 +1,21 @@
 #ifndef USERPROG_EXCEPTION_H
 #define USERPROG_EXCEPTION_H
 
+#include <stdbool.h>
+
 /* Page fault error code bits that describe the cause of the exception.  */
 #define PF_P 0x1    /* 0: not-present page. 1: access rights violation. */
 #define PF_W 0x2    /* 0: read, 1: write. */
 #define PF_U 0x4    /* 0: kernel, 1: user process. */
 
+struct spte;
+
+/* Number of pages the stack grows by, beyond the faulting page.
+   Controlled by kernel command-line option "-stkchunk=N". */
+extern int stack_chunk_pages;
+
 void exception_init (void);
 void exception_print_stats (void);
+bool page_in (struct spte *spte);
 
 #endif /* userprog/exception.h */
@@ -0,0 +1,292 @@
+#include "userprog/fd-table.h"
+#include <string.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "userprog/pipe.h"
+
+/* Bits in a word of USED or FULL. */
+#define WORD_BITS 32
+
+/* First capacity of a table. */
+#define INITIAL_CAPACITY WORD_BITS
+
+static bool grow (struct fd_table *table);
+static bool inherit (struct fd_table *table, struct fd_table *parent);
+static int next_fd (const struct fd_table *table, int fd);
+static void mark_used (struct fd_table *table, int fd);
+
+/* Returns a new table for a process started by a process whose table
+   is PARENT, or NULL if memory is short.  Files are not inherited, but
+   the console streams and pipe ends are, under the same fds.  Without
+   a PARENT, fds 0 and 1 are the keyboard and the console. */
+struct fd_table *
+fd_table_create (struct fd_table *parent)
+{
+  struct fd_table *table = calloc (1, sizeof *table);
+  if (table == NULL)
+    return NULL;
+  lock_init (&table->lock);
+  if (!grow (table) || !inherit (table, parent)) {
+    fd_table_destroy (table);
+    return NULL;
+  }
+  return table;
+}
+
+/* Releases every descriptor left in TABLE and frees it. */
+void
+fd_table_destroy (struct fd_table *table)
+{
+  if (table == NULL)
+    return;
+  for (int fd = fd_table_next (table, 0); fd >= 0;
+       fd = fd_table_next (table, fd + 1))
+    descriptor_release (table, fd_table_remove (table, fd));
+  free (table->descs);
+  free (table->used);
+  free (table);
+}
+
+/* Puts DESC in TABLE under the lowest free fd, growing TABLE if all
+   fds are in use, and returns that fd.  Returns -1 if TABLE is at
+   FD_TABLE_MAX or cannot grow. */
+int
+fd_table_insert (struct fd_table *table, struct descriptor *desc)
+{
+  int word = -1;
+  int fd = -1;
+
+  lock_acquire (&table->lock);
+  for (int i = 0; i < FD_TABLE_MAX / 1024; i++)
+    if (table->full[i] != UINT32_MAX) {
+      word = i * WORD_BITS + __builtin_ctz (~table->full[i]);
+      break;
+    }
+
+  /* Every word up to the capacity is full, so WORD is the first word
+     past it. */
+  if (word >= 0 && (word < table->capacity / WORD_BITS || grow (table))) {
+    fd = word * WORD_BITS + __builtin_ctz (~table->used[word]);
+    mark_used (table, fd);
+    table->descs[fd] = desc;
+  }
+  lock_release (&table->lock);
+  return fd;
+}
+
+/* Puts DESC in TABLE under FD, growing TABLE as needed.  Returns false
+   if FD is in use or out of range, or if TABLE cannot grow. */
+bool
+fd_table_install (struct fd_table *table, int fd, struct descriptor *desc)
+{
+  bool success = false;
+
+  if (fd < 0 || fd >= FD_TABLE_MAX)
+    return false;
+  lock_acquire (&table->lock);
+  while (fd >= table->capacity)
+    if (!grow (table))
+      goto done;
+  if (table->descs[fd] != NULL)
+    goto done;
+
+  mark_used (table, fd);
+  table->descs[fd] = desc;
+  success = true;
+
+ done:
+  lock_release (&table->lock);
+  return success;
+}
+
+/* Returns the descriptor of FD in TABLE with a new reference to it,
+   so that it stays open even if another thread closes FD, or NULL if
+   FD is not open.  The caller releases the descriptor. */
+struct descriptor *
+fd_table_get (struct fd_table *table, int fd)
+{
+  struct descriptor *desc = NULL;
+
+  lock_acquire (&table->lock);
+  if (fd >= 0 && fd < table->capacity && table->descs[fd] != NULL) {
+    desc = table->descs[fd];
+    desc->ref_cnt++;
+  }
+  lock_release (&table->lock);
+  return desc;
+}
+
+/* Frees FD in TABLE and returns its descriptor, or NULL if FD was not
+   open.  The caller releases the descriptor. */
+struct descriptor *
+fd_table_remove (struct fd_table *table, int fd)
+{
+  struct descriptor *desc = NULL;
+
+  lock_acquire (&table->lock);
+  if (fd >= 0 && fd < table->capacity && table->descs[fd] != NULL) {
+    int word = fd / WORD_BITS;
+    desc = table->descs[fd];
+    table->descs[fd] = NULL;
+    table->used[word] &= ~(1u << (fd % WORD_BITS));
+    table->full[word / WORD_BITS] &= ~(1u << (word % WORD_BITS));
+  }
+  lock_release (&table->lock);
+  return desc;
+}
+
+/* Returns the lowest open fd that is at least FD in TABLE, or -1 if
+   there is none. */
+int
+fd_table_next (struct fd_table *table, int fd)
+{
+  lock_acquire (&table->lock);
+  fd = next_fd (table, fd);
+  lock_release (&table->lock);
+  return fd;
+}
+
+/* Returns a new descriptor of TYPE for FILE or PIPE, referred to by
+   one fd, or NULL if memory is short.  Takes over the reference the
+   caller holds to FILE or to an end of PIPE. */
+struct descriptor *
+descriptor_create (enum descriptor_type type, struct file *file,
+                   struct pipe *pipe)
+{
+  struct descriptor *desc = malloc (sizeof *desc);
+  if (desc == NULL)
+    return NULL;
+  desc->type = type;
+  desc->ref_cnt = 1;
+  desc->file = file;
+  desc->pipe = pipe;
+  return desc;
+}
+
+/* Drops a reference to DESC, a descriptor of TABLE, closing what it
+   refers to and freeing it once nothing refers to it. */
+void
+descriptor_release (struct fd_table *table, struct descriptor *desc)
+{
+  if (desc == NULL)
+    return;
+  lock_acquire (&table->lock);
+  int ref_cnt = --desc->ref_cnt;
+  lock_release (&table->lock);
+  if (ref_cnt > 0)
+    return;
+
+  switch (desc->type) {
+    case DESC_FILE:
+      file_close (desc->file);
+      break;
+    case DESC_PIPE_READ:
+    case DESC_PIPE_WRITE:
+      pipe_close_end (desc->pipe, desc->type == DESC_PIPE_WRITE);
+      break;
+    default:
+      break;
+  }
+  free (desc);
+}
+
+/* Doubles the capacity of TABLE, or gives it its first one.  Returns
+   false if TABLE is at FD_TABLE_MAX or memory is short. */
+static bool
+grow (struct fd_table *table)
+{
+  int old_capacity = table->capacity;
+  int new_capacity = old_capacity == 0 ? INITIAL_CAPACITY : 2 * old_capacity;
+  if (new_capacity > FD_TABLE_MAX)
+    return false;
+
+  struct descriptor **descs = realloc (table->descs,
+                                       new_capacity * sizeof *descs);
+  if (descs == NULL)
+    return false;
+  table->descs = descs;
+  uint32_t *used = realloc (table->used,
+                            new_capacity / WORD_BITS * sizeof *used);
+  if (used == NULL)
+    return false;
+  table->used = used;
+
+  memset (descs + old_capacity, 0,
+          (new_capacity - old_capacity) * sizeof *descs);
+  memset (used + old_capacity / WORD_BITS, 0,
+          (new_capacity - old_capacity) / WORD_BITS * sizeof *used);
+  table->capacity = new_capacity;
+  return true;
+}
+
+/* Gives empty TABLE a descriptor of its own for every console stream
+   and pipe end open in PARENT, or the two console streams if PARENT is
+   NULL.  Returns false if memory is short. */
+static bool
+inherit (struct fd_table *table, struct fd_table *parent)
+{
+  bool success = true;
+
+  if (parent == NULL) {
+    struct descriptor *in = descriptor_create (DESC_CONSOLE_IN, NULL, NULL);
+    struct descriptor *out = descriptor_create (DESC_CONSOLE_OUT, NULL, NULL);
+    if (in == NULL || out == NULL) {
+      free (in);
+      free (out);
+      return false;
+    }
+    fd_table_install (table, 0, in);
+    fd_table_install (table, 1, out);
+    return true;
+  }
+
+  /* Other threads of the parent's process may be using its table. */
+  lock_acquire (&parent->lock);
+  for (int fd = next_fd (parent, 0); fd >= 0; fd = next_fd (parent, fd + 1)) {
+    const struct descriptor *p = parent->descs[fd];
+    if (p->type == DESC_FILE)
+      continue;
+
+    struct descriptor *desc = descriptor_create (p->type, NULL, p->pipe);
+    if (desc == NULL) {
+      success = false;
+      break;
+    }
+    if (!fd_table_install (table, fd, desc)) {
+      free (desc);
+      success = false;
+      break;
+    }
+    if (p->pipe != NULL)
+      pipe_open_end (p->pipe, p->type == DESC_PIPE_WRITE);
+  }
+  lock_release (&parent->lock);
+  return success;
+}
+
+/* Returns the lowest open fd that is at least FD in TABLE, or -1 if
+   there is none.  Skips the free fds a word at a time.  Must hold the
+   lock of TABLE. */
+static int
+next_fd (const struct fd_table *table, int fd)
+{
+  if (fd < 0)
+    fd = 0;
+  while (fd < table->capacity) {
+    uint32_t bits = table->used[fd / WORD_BITS] >> (fd % WORD_BITS);
+    if (bits != 0)
+      return fd + __builtin_ctz (bits);
+    fd = (fd / WORD_BITS + 1) * WORD_BITS;
+  }
+  return -1;
+}
+
+/* Marks FD, below the capacity of TABLE, as in use. */
+static void
+mark_used (struct fd_table *table, int fd)
+{
+  int word = fd / WORD_BITS;
+  table->used[word] |= 1u << (fd % WORD_BITS);
+  if (table->used[word] == UINT32_MAX)
+    table->full[word / WORD_BITS] |= 1u << (word % WORD_BITS);
+}
@@ -0,0 +1,60 @@
+#ifndef USERPROG_FD_TABLE_H
+#define USERPROG_FD_TABLE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "threads/synch.h"
+
+struct file;
+struct pipe;
+
+/* Most file descriptors a process can have open at once. */
+#define FD_TABLE_MAX 8192
+
+/* What a file descriptor refers to. */
+enum descriptor_type {
+  DESC_CONSOLE_IN,                    /* Keyboard input. */
+  DESC_CONSOLE_OUT,                   /* Console output. */
+  DESC_FILE,                          /* Open file. */
+  DESC_PIPE_READ,                     /* Read end of a pipe. */
+  DESC_PIPE_WRITE                     /* Write end of a pipe. */
+};
+
+/* An open console stream, file or pipe end, shared by the fds that
+   dup2 () made of the same fd. */
+struct descriptor {
+  enum descriptor_type type;          /* What it refers to. */
+  int ref_cnt;                        /* # of fds and calls using it. */
+  struct file *file;                  /* Open file, for DESC_FILE. */
+  struct pipe *pipe;                  /* Pipe, for DESC_PIPE_*. */
+};
+
+/* The descriptors of a process, indexed by file descriptor.  DESCS
+   starts small and doubles as needed.  A bit in USED is set for every
+   fd in use, and a bit in FULL for every word of USED with all bits
+   set, so that the lowest free fd is found by looking at a handful of
+   words whatever the number of open files.  The threads of a process
+   share its table, and LOCK serializes them.  LOCK also protects the
+   reference counts of the descriptors in the table. */
+struct fd_table {
+  struct descriptor **descs;          /* Descriptor of each fd, or NULL. */
+  uint32_t *used;                     /* Bit per fd, set if in use. */
+  uint32_t full[FD_TABLE_MAX / 1024]; /* Bit per word of USED, set if full. */
+  int capacity;                       /* # of fds in DESCS, multiple of 32. */
+  struct lock lock;                   /* Protects the members above. */
+};
+
+struct fd_table *fd_table_create (struct fd_table *parent);
+void fd_table_destroy (struct fd_table *table);
+int fd_table_insert (struct fd_table *table, struct descriptor *desc);
+bool fd_table_install (struct fd_table *table, int fd,
+                       struct descriptor *desc);
+struct descriptor *fd_table_get (struct fd_table *table, int fd);
+struct descriptor *fd_table_remove (struct fd_table *table, int fd);
+int fd_table_next (struct fd_table *table, int fd);
+
+struct descriptor *descriptor_create (enum descriptor_type type,
+                                      struct file *file, struct pipe *pipe);
+void descriptor_release (struct fd_table *table, struct descriptor *desc);
+
+#endif /* userprog/fd-table.h */
@@ -0,0 +1,215 @@
+#include "userprog/futex.h"
+#include <hash.h>
+#include <list.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
+#include "vm/spt.h"
+
+/* Identifies the word a futex lives in independently of the frame
+   holding it, which changes when the page is evicted and loaded
+   again.  A word of a file mapping, which includes shared memory
+   segments, is named by the file's inode and its offset in the file,
+   so that every process mapping the file finds the same futex.  Any
+   other word is private to the address space it is in, and is named
+   by that address space's supplemental page table and its address. */
+struct futex_key {
+  const void *base;                   /* Inode or supplemental page table. */
+  uintptr_t offset;                   /* Offset in the file or address. */
+};
+
+/* The threads waiting on one word.  Exists only while there are
+   waiters. */
+struct futex {
+  struct futex_key key;               /* Word waited on. */
+  struct list waiters;                /* List of struct futex_waiter. */
+  struct hash_elem elem;              /* Element in futexes. */
+};
+
+/* A thread in futex_sleep (). */
+struct futex_waiter {
+  struct thread *process;             /* Main thread of its process. */
+  struct semaphore sema;              /* Upped by futex_wakeup (). */
+  struct list_elem elem;              /* Element in struct futex. */
+};
+
+/* Every futex with waiters. */
+static struct hash futexes;
+
+/* Protects futexes.  Held from reading the word in futex_sleep () to
+   queueing the waiter, so that a futex_wakeup () that follows a change
+   of the word cannot come in between and be lost. */
+static struct lock futex_lock;
+
+static bool get_key (int *uaddr, struct futex_key *key);
+static unsigned futex_hash (const struct hash_elem *e, void *aux UNUSED);
+static bool futex_less (const struct hash_elem *a, const struct hash_elem *b,
+                        void *aux UNUSED);
+
+/* Initializes the futex table. */
+void
+futex_init (void)
+{
+  hash_init (&futexes, futex_hash, futex_less, NULL);
+  lock_init (&futex_lock);
+}
+
+/* Blocks the current thread until futex_wakeup () is called on the
+   word at UADDR, provided the word holds VAL.  Returns 0 after being
+   woken, or -1 at once if the word does not hold VAL, or if UADDR is
+   not an aligned, readable word.  Does not block in a process that is
+   exiting, see futex_wake_process (). */
+int
+futex_sleep (int *uaddr, int val)
+{
+  struct futex_key key;
+  struct futex_waiter waiter;
+  int word;
+
+  lock_acquire (&futex_lock);
+  if (process_killed () || !copy_from_user (&word, uaddr, sizeof word)
+      || word != val || !get_key (uaddr, &key)) {
+    lock_release (&futex_lock);
+    return -1;
+  }
+
+  struct futex *futex;
+  struct futex find;
+  find.key = key;
+  struct hash_elem *e = hash_find (&futexes, &find.elem);
+  if (e != NULL)
+    futex = hash_entry (e, struct futex, elem);
+  else if ((futex = malloc (sizeof *futex)) != NULL) {
+    futex->key = key;
+    list_init (&futex->waiters);
+    hash_insert (&futexes, &futex->elem);
+  } else {
+    lock_release (&futex_lock);
+    return -1;
+  }
+  waiter.process = process_current ();
+  sema_init (&waiter.sema, 0);
+  list_push_back (&futex->waiters, &waiter.elem);
+  lock_release (&futex_lock);
+
+  sema_down (&waiter.sema);
+  return 0;
+}
+
+/* Wakes up to N of the threads waiting on the word at UADDR, oldest
+   first.  Returns the number of threads woken. */
+int
+futex_wakeup (int *uaddr, int n)
+{
+  struct futex_key key;
+  int woken = 0;
+
+  lock_acquire (&futex_lock);
+  if (get_key (uaddr, &key)) {
+    struct futex find;
+    find.key = key;
+    struct hash_elem *e = hash_find (&futexes, &find.elem);
+    if (e != NULL) {
+      struct futex *futex = hash_entry (e, struct futex, elem);
+      while (woken < n && !list_empty (&futex->waiters)) {
+        struct futex_waiter *waiter = list_entry (
+            list_pop_front (&futex->waiters), struct futex_waiter, elem);
+        sema_up (&waiter->sema);
+        woken++;
+      }
+      if (list_empty (&futex->waiters)) {
+        hash_delete (&futexes, &futex->elem);
+        free (futex);
+      }
+    }
+  }
+  lock_release (&futex_lock);
+  return woken;
+}
+
+/* Wakes every thread of PROCESS waiting in futex_sleep (), so that
+   they see that the process is exiting. */
+void
+futex_wake_process (struct thread *process)
+{
+  struct hash_iterator it;
+
+  lock_acquire (&futex_lock);
+  hash_first (&it, &futexes);
+  while (hash_next (&it)) {
+    struct futex *futex = hash_entry (hash_cur (&it), struct futex, elem);
+    struct list_elem *e = list_begin (&futex->waiters);
+    while (e != list_end (&futex->waiters)) {
+      struct futex_waiter *waiter = list_entry (e, struct futex_waiter, elem);
+      e = list_next (e);
+      if (waiter->process == process) {
+        list_remove (&waiter->elem);
+        sema_up (&waiter->sema);
+      }
+    }
+  }
+
+  /* The hash cannot change while it is iterated, so futexes left
+     without waiters are freed afterward. */
+  for (;;) {
+    struct futex *empty = NULL;
+    hash_first (&it, &futexes);
+    while (empty == NULL && hash_next (&it)) {
+      struct futex *futex = hash_entry (hash_cur (&it), struct futex, elem);
+      if (list_empty (&futex->waiters))
+        empty = futex;
+    }
+    if (empty == NULL)
+      break;
+    hash_delete (&futexes, &empty->elem);
+    free (empty);
+  }
+  lock_release (&futex_lock);
+}
+
+/* Stores the key of the word at UADDR in KEY.  Returns false if
+   UADDR is not aligned or not in a page of the current process. */
+static bool
+get_key (int *uaddr, struct futex_key *key)
+{
+  struct thread *cur = thread_current ();
+
+  if ((uintptr_t) uaddr % sizeof *uaddr != 0 || !is_user_vaddr (uaddr))
+    return false;
+
+  struct spte *spte = spt_find (cur->spt, pg_round_down (uaddr));
+  if (spte == NULL)
+    return false;
+  if (spte->status == MMAP) {
+    key->base = file_get_inode (spte->file);
+    key->offset = spte->file_ofs + pg_ofs (uaddr);
+  } else {
+    key->base = cur->spt;
+    key->offset = (uintptr_t) uaddr;
+  }
+  return true;
+}
+
+/* Hash function of futexes, based on their key. */
+static unsigned
+futex_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct futex *futex = hash_entry (e, struct futex, elem);
+  return hash_bytes (&futex->key, sizeof futex->key);
+}
+
+/* Hash less function of futexes. */
+static bool
+futex_less (const struct hash_elem *a, const struct hash_elem *b,
+            void *aux UNUSED)
+{
+  const struct futex_key *ka = &hash_entry (a, struct futex, elem)->key;
+  const struct futex_key *kb = &hash_entry (b, struct futex, elem)->key;
+  if (ka->base != kb->base)
+    return ka->base < kb->base;
+  return ka->offset < kb->offset;
+}
@@ -0,0 +1,11 @@
+#ifndef USERPROG_FUTEX_H
+#define USERPROG_FUTEX_H
+
+struct thread;
+
+void futex_init (void);
+int futex_sleep (int *uaddr, int val);
+int futex_wakeup (int *uaddr, int n);
+void futex_wake_process (struct thread *process);
+
+#endif /* userprog/futex.h */
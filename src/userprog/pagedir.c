@@ -9,6 +9,7 @@
 
 static uint32_t *active_pd (void);
 static void invalidate_pagedir (uint32_t *);
+static bool split_large_pde (uint32_t *pd, uint32_t *pde, enum palloc_flags);
 
 /* Creates a new page directory that has mappings for kernel
    virtual addresses, but none for user virtual addresses.
@@ -35,7 +36,9 @@ pagedir_destroy (uint32_t *pd)
 
   ASSERT (pd != init_page_dir);
   for (pde = pd; pde < pd + pd_no (PHYS_BASE); pde++)
-    if (*pde & PTE_P) 
+    if ((*pde & PTE_P) && (*pde & PTE_PS))
+      palloc_free_multiple (pde_get_large_page (*pde), LGPG_PAGES);
+    else if (*pde & PTE_P) 
       {
         uint32_t *pt = pde_get_pt (*pde);
         uint32_t *pte;
@@ -53,7 +56,10 @@ pagedir_destroy (uint32_t *pd)
    If PD does not have a page table for VADDR, behavior depends
    on CREATE.  If CREATE is true, then a new page table is
    created and a pointer into it is returned.  Otherwise, a null
-   pointer is returned. */
+   pointer is returned.
+   If VADDR is mapped by a large page, the PDE itself is returned,
+   since it has the same flag bits as a PTE, unless CREATE is true,
+   in which case the large page is first split into 4 kB pages. */
 uint32_t *
 lookup_page (uint32_t *pd, const void *vaddr, bool create)
 {
@@ -67,6 +73,13 @@ lookup_page (uint32_t *pd, const void *vaddr, bool create)
   /* Check for a page table for VADDR.
      If one is missing, create one if requested. */
   pde = pd + pd_no (vaddr);
+  if (*pde & PTE_PS)
+    {
+      if (!create)
+        return pde;
+      if (!split_large_pde (pd, pde, PAL_ZERO))
+        return NULL;
+    }
   if (*pde == 0) 
     {
       if (create)
@@ -129,6 +142,10 @@ pagedir_get_page (uint32_t *pd, const void *uaddr)
   uint32_t *pte;
 
   ASSERT (is_user_vaddr (uaddr));
+
+  if (pagedir_is_large (pd, uaddr))
+    return pde_get_large_page (pd[pd_no (uaddr)])
+           + ((uintptr_t) uaddr & LGPGMASK);
   
   pte = lookup_page (pd, uaddr, false);
   if (pte != NULL && (*pte & PTE_P) != 0)
@@ -149,6 +166,10 @@ pagedir_clear_page (uint32_t *pd, void *upage)
   ASSERT (pg_ofs (upage) == 0);
   ASSERT (is_user_vaddr (upage));
 
+  /* Only this 4 kB page goes away, not the whole large page. */
+  if (pagedir_is_large (pd, upage))
+    split_large_pde (pd, pd + pd_no (upage), PAL_ASSERT | PAL_ZERO);
+
   pte = lookup_page (pd, upage, false);
   if (pte != NULL && (*pte & PTE_P) != 0)
     {
@@ -157,6 +178,72 @@ pagedir_clear_page (uint32_t *pd, void *upage)
     }
 }
 
+/* Adds a mapping in page directory PD from the 4 MB aligned user
+   virtual region starting at UPAGE to the physically contiguous,
+   4 MB aligned frames starting at KPAGE, using a single large page.
+   No part of the region may already have a page table.
+   Returns true if successful, false if the region is not free. */
+bool
+pagedir_set_large_page (uint32_t *pd, void *upage, void *kpage,
+                        bool writable)
+{
+  uint32_t *pde;
+
+  ASSERT (((uintptr_t) upage & LGPGMASK) == 0);
+  ASSERT (((uintptr_t) kpage & LGPGMASK) == 0);
+  ASSERT (is_user_vaddr (upage));
+  ASSERT (is_user_vaddr ((uint8_t *) upage + LGPGSIZE - 1));
+  ASSERT (pd != init_page_dir);
+
+  pde = pd + pd_no (upage);
+  if (*pde != 0)
+    return false;
+
+  *pde = pde_create_large_user (kpage, writable);
+  return true;
+}
+
+/* Returns true if VADDR is mapped by a large page in PD. */
+bool
+pagedir_is_large (uint32_t *pd, const void *vaddr)
+{
+  uint32_t pde = pd[pd_no (vaddr)];
+  return (pde & PTE_P) != 0 && (pde & PTE_PS) != 0;
+}
+
+/* Replaces the large page mapping VADDR in PD by a page table of
+   4 kB pages that map the same frames with the same rights, so
+   that they can be handled one by one, e.g. to be evicted.
+   Returns false if no page table could be allocated. */
+bool
+pagedir_split_large_page (uint32_t *pd, const void *vaddr)
+{
+  if (!pagedir_is_large (pd, vaddr))
+    return true;
+  return split_large_pde (pd, pd + pd_no (vaddr), PAL_ZERO);
+}
+
+/* Splits the large page PDE of PD, allocating the page table with
+   FLAGS.  The accessed and dirty bits of the large page are copied
+   into every 4 kB PTE. */
+static bool
+split_large_pde (uint32_t *pd, uint32_t *pde, enum palloc_flags flags)
+{
+  uint8_t *page = pde_get_large_page (*pde);
+  uint32_t pte_flags = *pde & (PTE_P | PTE_W | PTE_U | PTE_A | PTE_D);
+  uint32_t *pt = palloc_get_page (flags);
+  size_t i;
+
+  if (pt == NULL)
+    return false;
+
+  for (i = 0; i < LGPG_PAGES; i++)
+    pt[i] = vtop (page + i * PGSIZE) | pte_flags;
+  *pde = pde_create (pt);
+  invalidate_pagedir (pd);
+  return true;
+}
+
 /* Returns true if the PTE for virtual page VPAGE in PD is dirty,
    that is, if the page has been modified since the PTE was
    installed.
@@ -283,6 +370,18 @@ pagedir_activate (uint32_t *pd)
   asm volatile ("movl %0, %%cr3" : : "r" (vtop (pd)) : "memory");
 }
 
+/* Loads page directory PD like pagedir_activate(), unless it is
+   already active, which would only flush the TLB for nothing. */
+void
+pagedir_activate_if_changed (uint32_t *pd) 
+{
+  if (pd == NULL)
+    pd = init_page_dir;
+
+  if (active_pd () != pd)
+    pagedir_activate (pd);
+}
+
 /* Returns the currently active page directory. */
 static uint32_t *
 active_pd (void) 
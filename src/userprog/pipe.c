@@ -0,0 +1,232 @@
+#include "userprog/pipe.h"
+#include <stddef.h>
+#include <stdint.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "userprog/process.h"
+#include "userprog/uaccess.h"
+#include "vm/frame-table.h"
+
+/* Pages in the ring buffer of a pipe. */
+#define PIPE_PAGES 4
+#define PIPE_SIZE (PIPE_PAGES * PGSIZE)
+
+/* A pipe: a ring buffer of PIPE_PAGES user pool frames between the
+   processes holding its read and write ends.  HEAD and TAIL count the
+   bytes read and written since the pipe was created, so TAIL - HEAD
+   bytes are buffered, starting at HEAD % PIPE_SIZE.
+
+   A read of a whole page that starts on a page of the ring, into a
+   page aligned buffer, takes that frame for the buffer and leaves the
+   reader's old frame in the ring in its place, so the data written is
+   only copied once. */
+struct pipe {
+  struct lock lock;                   /* Protects all members. */
+  struct wait_queue waiters;          /* Woken on every change. */
+  void *pages[PIPE_PAGES];            /* The ring buffer. */
+  unsigned head;                      /* Bytes read. */
+  unsigned tail;                      /* Bytes written. */
+  int readers;                        /* # of read ends open. */
+  int writers;                        /* # of write ends open. */
+};
+
+static bool pipe_wait (struct pipe *pipe);
+static void pipe_free (struct pipe *pipe);
+
+/* Returns a new, empty pipe with one read end and one write end open,
+   or NULL if memory is short. */
+struct pipe *
+pipe_create (void)
+{
+  struct pipe *pipe = calloc (1, sizeof *pipe);
+  if (pipe == NULL)
+    return NULL;
+  for (int i = 0; i < PIPE_PAGES; i++)
+    if ((pipe->pages[i] = obtain_user_frame (false)) == NULL) {
+      pipe_free (pipe);
+      return NULL;
+    }
+
+  lock_init (&pipe->lock);
+  wait_queue_init (&pipe->waiters);
+  pipe->readers = pipe->writers = 1;
+  return pipe;
+}
+
+/* Opens another read end of PIPE, or write end if WRITER is true. */
+void
+pipe_open_end (struct pipe *pipe, bool writer)
+{
+  lock_acquire (&pipe->lock);
+  if (writer)
+    pipe->writers++;
+  else
+    pipe->readers++;
+  lock_release (&pipe->lock);
+}
+
+/* Closes a read end of PIPE, or write end if WRITER is true, waking up
+   the other side.  Frees PIPE once both sides are closed. */
+void
+pipe_close_end (struct pipe *pipe, bool writer)
+{
+  lock_acquire (&pipe->lock);
+  if (writer)
+    pipe->writers--;
+  else
+    pipe->readers--;
+  wait_queue_wake (&pipe->waiters);
+  bool unused = pipe->readers == 0 && pipe->writers == 0;
+  lock_release (&pipe->lock);
+
+  if (unused)
+    pipe_free (pipe);
+}
+
+/* Reads up to SIZE bytes from PIPE into user buffer UBUF, waiting
+   until there is data to read.  Returns the number of bytes read,
+   which is 0 once all write ends are closed and the pipe is drained,
+   or -1 if UBUF cannot be written or if the process starts exiting
+   while waiting. */
+int
+pipe_read (struct pipe *pipe, void *ubuf, unsigned size)
+{
+  uint8_t *dst = ubuf;
+  unsigned bytes_read = 0;
+  bool failed = false;
+
+  lock_acquire (&pipe->lock);
+  bool exiting = false;
+  while (pipe->tail == pipe->head && pipe->writers > 0 && !exiting)
+    exiting = !pipe_wait (pipe);
+  if (exiting) {
+    lock_release (&pipe->lock);
+    return -1;
+  }
+
+  while (bytes_read < size && pipe->head != pipe->tail) {
+    unsigned pos = pipe->head % PIPE_SIZE;
+    void **page = &pipe->pages[pos / PGSIZE];
+    unsigned chunk = PGSIZE - pos % PGSIZE;
+    if (chunk > pipe->tail - pipe->head)
+      chunk = pipe->tail - pipe->head;
+    if (chunk > size - bytes_read)
+      chunk = size - bytes_read;
+
+    void *old_page;
+    if (chunk == PGSIZE && pg_ofs (dst) == 0
+        && (old_page = swap_user_frame (dst, *page)) != NULL)
+      *page = old_page;
+    else if (!copy_to_user (dst, (uint8_t *) *page + pos % PGSIZE, chunk)) {
+      failed = bytes_read == 0;
+      break;
+    }
+    dst += chunk;
+    pipe->head += chunk;
+    bytes_read += chunk;
+  }
+
+  wait_queue_wake (&pipe->waiters);
+  lock_release (&pipe->lock);
+  return failed ? -1 : (int) bytes_read;
+}
+
+/* Writes SIZE bytes from user buffer UBUF to PIPE, waiting for room
+   in the ring buffer as needed.  Returns the number of bytes written,
+   which is less than SIZE only if all read ends were closed or the
+   process started exiting on the way, or -1 if that happened before
+   anything was written or UBUF cannot be read. */
+int
+pipe_write (struct pipe *pipe, const void *ubuf, unsigned size)
+{
+  const uint8_t *src = ubuf;
+  unsigned bytes_written = 0;
+  bool failed = false;
+
+  lock_acquire (&pipe->lock);
+  while (bytes_written < size) {
+    bool exiting = false;
+    while (pipe->tail - pipe->head == PIPE_SIZE && pipe->readers > 0
+           && !exiting)
+      exiting = !pipe_wait (pipe);
+    if (pipe->readers == 0 || exiting) {
+      failed = bytes_written == 0;
+      break;
+    }
+
+    unsigned pos = pipe->tail % PIPE_SIZE;
+    unsigned chunk = PGSIZE - pos % PGSIZE;
+    if (chunk > PIPE_SIZE - (pipe->tail - pipe->head))
+      chunk = PIPE_SIZE - (pipe->tail - pipe->head);
+    if (chunk > size - bytes_written)
+      chunk = size - bytes_written;
+
+    uint8_t *page = pipe->pages[pos / PGSIZE];
+    if (!copy_from_user (page + pos % PGSIZE, src, chunk)) {
+      failed = bytes_written == 0;
+      break;
+    }
+    src += chunk;
+    pipe->tail += chunk;
+    bytes_written += chunk;
+    wait_queue_wake (&pipe->waiters);
+  }
+  lock_release (&pipe->lock);
+  return failed ? -1 : (int) bytes_written;
+}
+
+/* Returns true if pipe_read () on PIPE would not wait, or pipe_write ()
+   if WRITER is true. */
+bool
+pipe_ready (struct pipe *pipe, bool writer)
+{
+  lock_acquire (&pipe->lock);
+  bool ready = writer
+               ? pipe->tail - pipe->head < PIPE_SIZE || pipe->readers == 0
+               : pipe->tail != pipe->head || pipe->writers == 0;
+  lock_release (&pipe->lock);
+  return ready;
+}
+
+/* Returns the wait queue of PIPE, woken whenever data goes in or out
+   of PIPE or an end of it is closed. */
+struct wait_queue *
+pipe_waiters (struct pipe *pipe)
+{
+  return &pipe->waiters;
+}
+
+/* Waits for PIPE to change, or for the current process to start
+   exiting, in which case returns false.  Must hold PIPE's lock, which
+   is released while waiting. */
+static bool
+pipe_wait (struct pipe *pipe)
+{
+  struct semaphore wake;
+  struct wait_entry pipe_entry, exit_entry;
+
+  /* Changes need the lock, so none can be missed before waiting. */
+  sema_init (&wake, 0);
+  wait_queue_add (&pipe->waiters, &pipe_entry, &wake);
+  process_add_exit_waiter (&exit_entry, &wake);
+  if (!process_killed ()) {
+    lock_release (&pipe->lock);
+    sema_down (&wake);
+    lock_acquire (&pipe->lock);
+  }
+  wait_queue_remove (&pipe_entry);
+  wait_queue_remove (&exit_entry);
+  return !process_killed ();
+}
+
+/* Frees PIPE and its ring buffer. */
+static void
+pipe_free (struct pipe *pipe)
+{
+  for (int i = 0; i < PIPE_PAGES; i++)
+    if (pipe->pages[i] != NULL)
+      palloc_free_page (pipe->pages[i]);
+  free (pipe);
+}
@@ -0,0 +1,17 @@
+#ifndef USERPROG_PIPE_H
+#define USERPROG_PIPE_H
+
+#include <stdbool.h>
+
+struct pipe;
+struct wait_queue;
+
+struct pipe *pipe_create (void);
+void pipe_open_end (struct pipe *pipe, bool writer);
+void pipe_close_end (struct pipe *pipe, bool writer);
+int pipe_read (struct pipe *pipe, void *ubuf, unsigned size);
+int pipe_write (struct pipe *pipe, const void *ubuf, unsigned size);
+bool pipe_ready (struct pipe *pipe, bool writer);
+struct wait_queue *pipe_waiters (struct pipe *pipe);
+
+#endif /* userprog/pipe.h */
@@ -20,11 +20,28 @@
 #include "../threads/thread.h"
 #include "../threads/vaddr.h"
 #include "../userprog/syscall.h"
+#include "../userprog/fd-table.h"
+#include "../userprog/uaccess.h"
 #include "../threads/malloc.h"
 #include "../vm/frame-table.h"
 #include "vm/spt.h"
 
+/* A thread of a user process other than its main thread.  The record
+   outlives the thread until another thread of the process joins it,
+   or until the process exits. */
+struct user_thread
+  {
+    tid_t tid;                  /* Its tid, TID_ERROR until known. */
+    void (*eip) (void);         /* Where it starts in user mode. */
+    void *esp;                  /* Its initial user stack pointer. */
+    bool joining;               /* Some thread joins it. */
+    struct semaphore exited;    /* Upped when it has exited. */
+    struct list_elem elem;      /* Element in the process's threads. */
+  };
+
 static thread_func start_process NO_RETURN;
+static thread_func start_thread NO_RETURN;
+static void leave_process (void);
 static bool load (const char *, void (**eip) (void), void **);
 static bool load_into_spt (void *, struct file *, off_t, size_t, bool);
 static int next_pid;
@@ -61,9 +78,6 @@ process_execute (const char *command)
 static void
 start_process (void *command_)
 {
-  struct spte *spte = new_spte (PHYS_BASE - PGSIZE);
-  spte->status = FRAME;
-  spte->value = thread_current ();
   lock_acquire (&ap_lock);
 
   struct ap *ap = (struct ap *) malloc (sizeof (struct ap));
@@ -82,9 +96,22 @@ start_process (void *command_)
     exit (-1);
   }
 
+  /* The parent inherits nothing from us, and fd_table_create () keeps
+     the other threads of its process off its table while we copy it. */
+  struct thread *cur = thread_current ();
+  cur->fd_table = fd_table_create (cur->parent != NULL
+                                   ? cur->parent->fd_table : NULL);
+  if (cur->fd_table == NULL) {
+    palloc_free_page (command_);
+    free (ap);
+    lock_release (&ap_lock);
+    exit (-1);
+  }
+
   char *file_name = ap->argv[0];
   int fd = open (file_name);
-  file_deny_write (thread_current ()->fd_table[fd]);
+  if (fd >= 0)
+    file_deny_write (fd_table_get (cur->fd_table, fd)->file);
 
   memcpy (thread_current ()->name, file_name, ap->arg_length[0] + 1);
 
@@ -132,7 +159,7 @@ start_process (void *command_)
 int
 process_wait (tid_t child_tid) 
 {
-  struct list *childs = &thread_current ()->child_list;
+  struct list *childs = &process_current ()->child_list;
   struct child *child_process = NULL;
 
   /* Look for the child process in the list of children */
@@ -153,8 +180,9 @@ process_wait (tid_t child_tid)
   /* Child process has not exited. */
   if (!child_process->exited) {
     child_process->waited = true;
-    /* Wait for the child to exit. */
-    sema_down (&child_process->sema);
+    /* Wait for the child to exit, unless this process exits first. */
+    if (!process_sema_down (&child_process->sema))
+      return -1;
   }
 
   return child_process->exit_status;
@@ -167,6 +195,16 @@ process_exit (void)
   struct thread *cur = thread_current ();
   uint32_t *pd;
 
+  if (cur->process != cur) {
+    leave_process ();
+    return;
+  }
+
+  /* Every other thread is gone, see exit (). */
+  while (!list_empty (&cur->threads))
+    free (list_entry (list_pop_front (&cur->threads), struct user_thread,
+                      elem));
+
   /* Destroy the current process's page directory and switch back
      to the kernel-only page directory. */
   pd = cur->pagedir;
@@ -181,10 +219,221 @@ process_exit (void)
          that's been freed (and cleared). */
       cur->pagedir = NULL;
       pagedir_activate (NULL);
-      free_all_user_pages(cur);
+      free_all_user_pages(cur, pd);
+    }
+}
+
+/* Makes the current thread, which is not the main thread of its
+   process, leave the process: it drops its pointers to the address
+   space and the open files, which belong to the main thread, then
+   tells whoever joins it and the main thread, which may be waiting for
+   it in process_wait_threads (). */
+static void
+leave_process (void)
+{
+  struct thread *cur = thread_current ();
+  struct thread *process = cur->process;
+
+  cur->pagedir = NULL;
+  pagedir_activate (NULL);
+  cur->fd_table = NULL;
+#ifdef VM
+  cur->spt = NULL;
+#endif
+
+  /* Once the count drops, the main thread may tear the process down,
+     so PROCESS must not be touched afterward. */
+  enum intr_level old_level = intr_disable ();
+  sema_up (&cur->user_thread->exited);
+  process->thread_cnt--;
+  sema_up (&process->threads_exited);
+  intr_set_level (old_level);
+}
+
+/* Returns the main thread of the running thread's process, which
+   holds the per-process members of struct thread. */
+struct thread *
+process_current (void)
+{
+  return thread_current ()->process;
+}
+
+/* Returns true if the running thread must exit instead of returning
+   to user mode, because its process is exiting or was chosen by the
+   out-of-memory killer. */
+bool
+process_killed (void)
+{
+  struct thread *process = process_current ();
+
+#ifdef VM
+  if (process->oom_killed)
+    return true;
+#endif
+  return process->exiting;
+}
+
+/* Adds ENTRY to the wait queue woken when the current process starts
+   exiting, so that SEMA is upped then, see wait_queue_add ().  A
+   thread that blocks on behalf of its process uses it to wake up and
+   give up the wait, since the main thread cannot finish exiting until
+   every other thread has.  Remove ENTRY with wait_queue_remove (). */
+void
+process_add_exit_waiter (struct wait_entry *entry, struct semaphore *sema)
+{
+  wait_queue_add (&process_current ()->exit_waiters, entry, sema);
+}
+
+/* Downs SEMA, unless the current process is exiting or starts exiting
+   first.  Returns false in that case, and SEMA may be left upped, so
+   it must not be used again once the process is exiting. */
+bool
+process_sema_down (struct semaphore *sema)
+{
+  struct wait_entry entry;
+
+  process_add_exit_waiter (&entry, sema);
+  if (!process_killed ())
+    sema_down (sema);
+  wait_queue_remove (&entry);
+  return !process_killed ();
+}
+
+/* Makes the running thread exit if process_killed ().  Called on the
+   way back to user mode from interrupts and system calls. */
+void
+process_check_killed (void)
+{
+  if (process_killed ())
+    {
+      intr_enable ();
+      exit (-1);
     }
 }
 
+/* Starts a thread in the current process that calls ENTRY (ARG) in
+   user mode, with its stack ending at STACK.  Nothing is above the
+   call on the stack, so ENTRY must not return; lib/user/syscall.c
+   makes threads end when their function returns instead.  Returns
+   the thread's tid, or TID_ERROR if it cannot be started. */
+tid_t
+process_spawn_thread (void (*entry) (void *), void *arg, void *stack)
+{
+  struct thread *process = process_current ();
+  void *frame[2] = { NULL, arg };       /* Return address and argument. */
+  void *esp = (uint8_t *) stack - sizeof frame;
+
+  if (process->exiting || !is_user_vaddr (entry)
+      || !copy_to_user (esp, frame, sizeof frame))
+    return TID_ERROR;
+
+  struct user_thread *ut = malloc (sizeof *ut);
+  if (ut == NULL)
+    return TID_ERROR;
+  ut->tid = TID_ERROR;
+  ut->eip = (void (*) (void)) entry;
+  ut->esp = esp;
+  ut->joining = false;
+  sema_init (&ut->exited, 0);
+
+  /* Count the thread before it can run, so that exit () waits for
+     it. */
+  enum intr_level old_level = intr_disable ();
+  list_push_back (&process->threads, &ut->elem);
+  process->thread_cnt++;
+  intr_set_level (old_level);
+
+  tid_t tid = thread_create_user (process->name, PRI_DEFAULT, start_thread,
+                                  ut);
+  old_level = intr_disable ();
+  if (tid != TID_ERROR)
+    ut->tid = tid;
+  else {
+    list_remove (&ut->elem);
+    process->thread_cnt--;
+  }
+  intr_set_level (old_level);
+
+  if (tid == TID_ERROR)
+    free (ut);
+  return tid;
+}
+
+/* A thread function that enters user mode for a thread started by
+   process_spawn_thread (). */
+static void
+start_thread (void *ut_)
+{
+  struct user_thread *ut = ut_;
+
+  thread_current ()->user_thread = ut;
+  if (process_killed ())
+    thread_exit ();
+
+  struct intr_frame if_;
+  memset (&if_, 0, sizeof if_);
+  if_.gs = if_.fs = if_.es = if_.ds = if_.ss = SEL_UDSEG;
+  if_.cs = SEL_UCSEG;
+  if_.eflags = FLAG_IF | FLAG_MBS;
+  if_.eip = ut->eip;
+  if_.esp = ut->esp;
+
+  /* Same as at the end of start_process (). */
+  asm volatile ("movl %0, %%esp; jmp intr_exit" : : "g" (&if_) : "memory");
+  NOT_REACHED ();
+}
+
+/* Waits for thread TID of the current process to exit.  Returns 0, or
+   -1 at once if TID is not another thread of the process started by
+   process_spawn_thread (), or if some thread already joins it, or
+   once the process starts exiting. */
+int
+process_join_thread (tid_t tid)
+{
+  struct thread *process = process_current ();
+  struct user_thread *ut = NULL;
+  struct list_elem *e;
+
+  enum intr_level old_level = intr_disable ();
+  for (e = list_begin (&process->threads); e != list_end (&process->threads);
+       e = list_next (e)) {
+    struct user_thread *t = list_entry (e, struct user_thread, elem);
+    if (t->tid == tid && tid != TID_ERROR && !t->joining
+        && t != thread_current ()->user_thread) {
+      t->joining = true;
+      ut = t;
+      break;
+    }
+  }
+  intr_set_level (old_level);
+  if (ut == NULL)
+    return -1;
+
+  /* The record stays in the list if the process exits first, so that
+     process_exit () frees it. */
+  if (!process_sema_down (&ut->exited))
+    return -1;
+  old_level = intr_disable ();
+  list_remove (&ut->elem);
+  intr_set_level (old_level);
+  free (ut);
+  return 0;
+}
+
+/* Waits until every thread of the current process but the running
+   one, which must be the main thread, has exited.  If the process is
+   exiting, threads running user code exit at their next interrupt,
+   and threads in the kernel when they are done with it. */
+void
+process_wait_threads (void)
+{
+  struct thread *cur = thread_current ();
+
+  ASSERT (cur->process == cur);
+  while (cur->thread_cnt > 0)
+    sema_down (&cur->threads_exited);
+}
+
 /* Sets up the CPU for running user code in the current
    thread.
    This function is called on every context switch. */
@@ -193,8 +442,10 @@ process_activate (void)
 {
   struct thread *t = thread_current ();
 
-  /* Activate thread's page tables. */
-  pagedir_activate (t->pagedir);
+  /* Activate thread's page tables.  Kernel mappings are global, so
+     reloading CR3 only flushes user translations, and it is skipped
+     altogether when the previous thread used the same page tables. */
+  pagedir_activate_if_changed (t->pagedir);
 
   /* Set thread's kernel stack for use in processing
      interrupts. */
@@ -505,12 +756,20 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 static bool
 setup_stack (void **esp) 
 {
-  if (allocate_user_page (((uint8_t *) PHYS_BASE) - PGSIZE, true, true)
-                                                               != NULL) {
-    *esp = PHYS_BASE;
-    return true;
-  }
-  return false;
+  uint8_t *upage = ((uint8_t *) PHYS_BASE) - PGSIZE;
+  struct spte *spte = new_spte (upage);
+  if (spte == NULL)
+    return false;
+  void *kpage = allocate_user_page (upage, true, true);
+  if (kpage == NULL)
+    return false;
+  lock_acquire (&spt_lock);
+  spte->status = FRAME;
+  spte->value = kpage;
+  lock_release (&spt_lock);
+
+  *esp = PHYS_BASE;
+  return true;
 }
 
 /* Record all info into sup_page. */
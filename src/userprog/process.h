@@ -7,5 +7,14 @@ tid_t process_execute (const char *command);
 int process_wait (tid_t);
 void process_exit (void);
 void process_activate (void);
+struct thread *process_current (void);
+bool process_killed (void);
+void process_check_killed (void);
+void process_add_exit_waiter (struct wait_entry *entry,
+                              struct semaphore *sema);
+bool process_sema_down (struct semaphore *sema);
+tid_t process_spawn_thread (void (*entry) (void *), void *arg, void *stack);
+int process_join_thread (tid_t tid);
+void process_wait_threads (void);
 
 #endif /* userprog/process.h */
@@ -3,52 +3,128 @@
 #include "threads/malloc.h"
 #include "../userprog/syscall.h"
 #include "../lib/user/syscall.h"
+#include "../threads/flags.h"
+#include "../threads/init.h"
 #include "../threads/interrupt.h"
+#include "../threads/palloc.h"
 #include "../threads/thread.h"
 #include "../threads/vaddr.h"
 #include "../threads/synch.h"
 #include "../filesys/file.h"
 #include "../filesys/filesys.h"
+#include "../filesys/inode.h"
 #include "../devices/shutdown.h"
 #include "../devices/input.h"
+#include "../devices/timer.h"
+#include "gdt.h"
 #include "pagedir.h"
 #include "argument-parsing.h"
 #include "process.h"
+#include "tss.h"
 #include "vm/frame-table.h"
+#include "vm/page-cache.h"
+#include "vm/shm.h"
+#include "exception.h"
+#include "uaccess.h"
+#include "aio.h"
+#include "fd-table.h"
+#include "futex.h"
+#include "pipe.h"
 
-int *arg[MAX_ARGUMENT_NUMBER];
+/* Model-specific registers read by SYSENTER. */
+#define MSR_SYSENTER_CS 0x174
+#define MSR_SYSENTER_ESP 0x175
+#define MSR_SYSENTER_EIP 0x176
 
 static void syscall_handler (struct intr_frame *);
-static void *accessUserMemory (uint32_t *, const void *);
+void syscall_sysenter_handler (struct intr_frame *);
+static char *get_string (const char *ustr);
+static struct descriptor *get_descriptor (int fd);
+static void put_descriptor (struct descriptor *desc);
+static void check_buffer (const void *ubuf, unsigned size, bool write);
+static bool is_writable_range (const void *ubuf, unsigned size);
+static mapid_t map_file (struct file *file, void *addr);
+static void munmap_all (void);
+static void write_back_range (void *start, void *end);
+static int read_file (struct file *file, uint8_t *buffer, unsigned length);
+static void exit_thread (void) NO_RETURN;
 struct semaphore exec_sema;
 bool exec_load_success;
 
-/* Registers internal interrupt 0x30 to invoke syscall_handler. */
+/* Writes VALUE to model-specific register MSR. */
+static void
+wrmsr (uint32_t msr, uint32_t value)
+{
+  asm volatile ("wrmsr" : : "c" (msr), "a" (value), "d" (0));
+}
+
+/* Registers internal interrupt 0x30 to invoke syscall_handler, and
+   points SYSENTER at syscall_sysenter_entry if the CPU has it.
+   SYSENTER takes its stack pointer from the esp0 member of the TSS,
+   which tss_update () keeps pointing at the current thread's kernel
+   stack, so the MSRs never need to change. */
 void
 syscall_init (void) 
 {
+  extern void syscall_sysenter_entry (void);
+
   intr_register_int (0x30, 3, INTR_ON, syscall_handler, "syscall");
   sema_init (&exec_sema, 0);
+
+  if (cpuid_features () & CPUID_SEP) {
+    wrmsr (MSR_SYSENTER_CS, SEL_KCSEG);
+    wrmsr (MSR_SYSENTER_ESP, (uint32_t) tss_esp0 ());
+    wrmsr (MSR_SYSENTER_EIP, (uint32_t) syscall_sysenter_entry);
+  }
+}
+
+/* Handles a system call made with SYSENTER, see syscall-entry.S. */
+void
+syscall_sysenter_handler (struct intr_frame *f)
+{
+  syscall_handler (f);
+
+  /* Same as at the end of intr_handler (). */
+  process_check_killed ();
 }
 
+/* Copies the first NUMBER arguments of the system call from the user
+   stack into ARG, terminating the process if they are not readable. */
 static void
-get_argument (struct intr_frame *f, int number)
+get_argument (struct intr_frame *f, int *arg, int number)
 {
-  for (int i = 0; i < number; i++) {
-    arg[i] = (int *) accessUserMemory (
-      thread_current ()->pagedir, ((int *) (f->esp)) + i + 1);
-  }
+  if (!copy_from_user (arg, (int *) f->esp + 1, number * sizeof *arg))
+    exit (-1);
+}
+
+/* Returns the descriptor of fd, or NULL if fd is not open.  The
+   descriptor stays open, even if another thread closes fd, until the
+   caller releases it with put_descriptor (). */
+static struct descriptor *
+get_descriptor (int fd)
+{
+  struct fd_table *fd_table = thread_current ()->fd_table;
+  return fd_table != NULL ? fd_table_get (fd_table, fd) : NULL;
 }
 
-/* Returns the pointer to the file associated with the fd. */
-static struct file *
-get_file_with_fd (int fd)
+/* Like get_descriptor (), but returns NULL unless fd is open on a
+   file. */
+static struct descriptor *
+get_file_descriptor (int fd)
 {
-  if (0 <= fd && fd < MAX_OPEN_FILE) {
-    return thread_current ()->fd_table[fd];
-  } else {
+  struct descriptor *desc = get_descriptor (fd);
+  if (desc != NULL && desc->type != DESC_FILE) {
+    put_descriptor (desc);
     return NULL;
   }
+  return desc;
+}
+
+/* Releases DESC, returned by get_descriptor (). */
+static void
+put_descriptor (struct descriptor *desc)
+{
+  descriptor_release (thread_current ()->fd_table, desc);
 }
 
 /* Terminates Pintos by calling shutdown_power_off (). */
@@ -59,19 +135,41 @@ halt (void)
 }
 
 /* Terminates the current user program, 
-   sending its exit status to the kernel. */
+   sending its exit status to the kernel.  The first thread of the
+   process to call it sets the status and wakes the other threads
+   blocked on behalf of the process, see process_add_exit_waiter ().
+   They exit on their way back to user mode, see process_killed (); the
+   main thread waits for them before releasing the process. */
 void
 exit (int status)
 {
   struct thread *cur = thread_current ();
-  printf ("%s: exit(%d)\n", cur->name, status);
-  if (cur->child != NULL) {
-    cur->child->exit_status = status;
-  }
+  struct thread *process = cur->process;
 
-  for (int fd = 0; fd < MAX_OPEN_FILE; fd++) {
-    close (fd);
+  /* Several threads may call exit () at once, only one goes first. */
+  enum intr_level old_level = intr_disable ();
+  bool first = !process->exiting;
+  process->exiting = true;
+  intr_set_level (old_level);
+
+  if (first) {
+    printf ("%s: exit(%d)\n", process->name, status);
+    if (process->child != NULL) {
+      process->child->exit_status = status;
+    }
+    futex_wake_process (process);
+    wait_queue_wake (&process->exit_waiters);
   }
+  if (cur != process)
+    thread_exit ();
+  process_wait_threads ();
+
+  /* Write back and unmap every mapping before the files are closed. */
+  munmap_all ();
+  aio_release_all ();
+
+  fd_table_destroy (cur->fd_table);
+  cur->fd_table = NULL;
 
   thread_exit ();
 }
@@ -128,51 +226,130 @@ remove (const char *file)
 
 /* Writes size bytes from buffer to the open file fd.
    Returns the number of bytes actually written. 
-   Fd 1 writes to the console. */
+   Fd 1 writes to the console, unless dup2 () replaced it. */
 int
 write (int fd, const void *buffer, unsigned size) {
-  if (fd == 1) {
-    putbuf (buffer, size);
-    return size;
-  } else {
-    struct file *file = get_file_with_fd (fd);
-    if (file != NULL) {
-      int bytes_written = file_write (file, buffer, size);
-      return bytes_written;
-    } else {
-      return -1;
+  struct descriptor *desc = get_descriptor (fd);
+  int result;
+  if (desc == NULL)
+    return -1;
+
+  switch (desc->type) {
+    case DESC_CONSOLE_OUT:
+      putbuf (buffer, size);
+      result = size;
+      break;
+    case DESC_FILE:
+      result = file_write (desc->file, buffer, size);
+      break;
+    case DESC_PIPE_WRITE:
+      result = pipe_write (desc->pipe, buffer, size);
+      break;
+    default:
+      result = -1;
+      break;
+  }
+  put_descriptor (desc);
+  return result;
+}
+
+/* Stores the next key pressed in *C, waiting for one if there is none
+   yet.  Returns false without waiting any longer once the process
+   starts exiting. */
+static bool
+getc_unless_exiting (char *c)
+{
+  struct semaphore wake;
+  struct wait_entry input_entry, exit_entry;
+  bool got = false;
+
+  sema_init (&wake, 0);
+  wait_queue_add (input_waiters (), &input_entry, &wake);
+  process_add_exit_waiter (&exit_entry, &wake);
+  for (;;) {
+    /* Another thread may take the key between the check and the
+       read, so do both at once. */
+    enum intr_level old_level = intr_disable ();
+    if (input_ready ()) {
+      *c = input_getc ();
+      got = true;
     }
+    intr_set_level (old_level);
+    if (got || process_killed ())
+      break;
+    sema_down (&wake);
   }
+  wait_queue_remove (&input_entry);
+  wait_queue_remove (&exit_entry);
+  return got;
 }
 
 /* Reads size bytes from the file open as fd into buffer. Returns the number of
    bytes actually read (0 at end of file), or -1 if the file could not be read.
-   Fd 0 reads from the keyboard. */
+   Fd 0 reads from the keyboard, unless dup2 () replaced it. */
 int
 read (int fd, void *buffer, unsigned length)
 {
-  if (fd == 0) {
-    unsigned int total = 0;
-    char *pos = (char *) buffer;
-    while (total < length) {
-      char c = input_getc();
-      if (c == '\0' || c == EOF) {
-        break;
+  struct descriptor *desc = get_descriptor (fd);
+  int result;
+  if (desc == NULL)
+    return -1;
+
+  switch (desc->type) {
+    case DESC_CONSOLE_IN: {
+      unsigned int total = 0;
+      char *pos = (char *) buffer;
+      while (total < length) {
+        char c;
+        if (!getc_unless_exiting (&c) || c == '\0' || c == EOF) {
+          break;
+        }
+        *pos++ = c;
+        total++;
       }
-      *pos++ = c;
-      total++;
-    }
-    *pos = '\0';
-    return total;
-  } else {
-    struct file *file = get_file_with_fd (fd);
-    if (file != NULL) {
-      int bytes_read = file_read (file, (void *) buffer, length);
-      return bytes_read;
-    } else {
-      return -1;
+      *pos = '\0';
+      result = total;
+      break;
     }
+    case DESC_FILE:
+      result = read_file (desc->file, buffer, length);
+      break;
+    case DESC_PIPE_READ:
+      result = pipe_read (desc->pipe, buffer, length);
+      break;
+    default:
+      result = -1;
+      break;
+  }
+  put_descriptor (desc);
+  return result;
+}
+
+/* Reads LENGTH bytes from FILE into BUFFER. When BUFFER and the file
+   position are both page aligned, every whole page of file data is
+   mapped from the page cache into BUFFER copy-on-write instead of
+   being copied. */
+static int
+read_file (struct file *file, uint8_t *buffer, unsigned length)
+{
+  struct inode *inode = file_get_inode (file);
+  int bytes_read = 0;
+
+  if (pg_ofs (buffer) != 0 || file_tell (file) % PGSIZE != 0)
+    return file_read (file, buffer, length);
+
+  while (length >= PGSIZE) {
+    off_t offset = file_tell (file);
+    if (offset + PGSIZE <= inode_length (inode)
+        && page_cache_map_cow (inode, offset, buffer))
+      file_seek (file, offset + PGSIZE);
+    else if (file_read (file, buffer, PGSIZE) != PGSIZE)
+      return bytes_read + (file_tell (file) - offset);
+    buffer += PGSIZE;
+    length -= PGSIZE;
+    bytes_read += PGSIZE;
   }
+  return bytes_read + file_read (file, buffer, length);
 }
 
 /* Waits for a child process pid and retrieves the child’s exit status. */
@@ -191,39 +368,48 @@ open (const char *file)
   struct file *file_ptr = filesys_open (file);
   lock_release (&filesys_lock);
 
-  if (file_ptr != NULL) {
-    struct file **fd_table = thread_current ()->fd_table;
-    for (int fd = 2; fd < MAX_OPEN_FILE; fd++) {
-      if (fd_table[fd] == NULL) {
-        fd_table[fd] = file_ptr;
-        return fd;
-      }
-    }
-  }
+  if (file_ptr == NULL)
+    return -1;
 
-  return -1;
+  struct fd_table *fd_table = thread_current ()->fd_table;
+  struct descriptor *desc = descriptor_create (DESC_FILE, file_ptr, NULL);
+  int fd = -1;
+  if (fd_table != NULL && desc != NULL)
+    fd = fd_table_insert (fd_table, desc);
+  if (fd < 0) {
+    free (desc);
+    file_close (file_ptr);
+  }
+  return fd;
 }
 
-/* Closes file descriptor fd. */
+/* Closes file descriptor fd.  Fds 0 and 1 stay open while they refer
+   to the console, and so does a file that is still memory mapped. */
 void
 close (int fd)
 {
-  if (0 <= fd && fd < MAX_OPEN_FILE) {
-    struct file *file_ptr = get_file_with_fd (fd);
+  struct fd_table *fd_table = thread_current ()->fd_table;
+  struct descriptor *desc = get_descriptor (fd);
+  if (desc == NULL)
+    return;
+  bool keep = (fd == 0 || fd == 1) && (desc->type == DESC_CONSOLE_IN
+                                       || desc->type == DESC_CONSOLE_OUT);
 
+  if (desc->type == DESC_FILE) {
     struct hash_iterator it;
-	  hash_first (&it, &thread_current ()->mmapped_file_table);
-	  while (hash_next (&it)) {
-		struct mmapped_file *mmapped_file = hash_entry (hash_cur (&it),
-                                                    struct mmapped_file, elem);
-		if (mmapped_file->file == file_ptr) {
-			return;
-		}
-	}
-    file_close (file_ptr);
-
-    thread_current ()->fd_table[fd] = NULL;
+    hash_first (&it, &process_current ()->mmapped_file_table);
+    while (hash_next (&it)) {
+      struct mmapped_file *mmapped_file = hash_entry (hash_cur (&it),
+                                                      struct mmapped_file,
+                                                      elem);
+      if (mmapped_file->file == desc->file)
+        keep = true;
+    }
   }
+
+  put_descriptor (desc);
+  if (!keep)
+    descriptor_release (fd_table, fd_table_remove (fd_table, fd));
 }
 
 /* Returns the size, in bytes, of the file open as fd.
@@ -231,14 +417,13 @@ close (int fd)
 int
 filesize (int fd)
 {
-  if (0 <= fd && fd < MAX_OPEN_FILE) {
-    struct file *file_ptr = get_file_with_fd (fd);
+  struct descriptor *desc = get_file_descriptor (fd);
 
-    if (file_ptr != NULL) {
-      int size = file_length (file_ptr);
+  if (desc != NULL) {
+    int size = file_length (desc->file);
 
-      return size;
-    }
+    put_descriptor (desc);
+    return size;
   }
 
   return -1;
@@ -249,12 +434,11 @@ filesize (int fd)
 void
 seek (int fd, unsigned position)
 {
-  if (0 <= fd && fd < MAX_OPEN_FILE) {
-    struct file *file_ptr = get_file_with_fd (fd);
+  struct descriptor *desc = get_file_descriptor (fd);
 
-    if (file_ptr != NULL) {
-      file_seek (file_ptr, position);
-    }
+  if (desc != NULL) {
+    file_seek (desc->file, position);
+    put_descriptor (desc);
   }
 }
 
@@ -264,14 +448,13 @@ seek (int fd, unsigned position)
 unsigned
 tell (int fd)
 {
-  if (0 <= fd && fd < MAX_OPEN_FILE) {
-    struct file *file_ptr = get_file_with_fd (fd);
+  struct descriptor *desc = get_file_descriptor (fd);
 
-    if (file_ptr != NULL) {
-      unsigned pos = file_tell (file_ptr);
+  if (desc != NULL) {
+    unsigned pos = file_tell (desc->file);
 
-      return pos;
-    }
+    put_descriptor (desc);
+    return pos;
   }
 
   return -1;
@@ -291,21 +474,36 @@ mmap (int fd, void *addr)
   }
 
   /* File must not be empty */
-  struct file *file = get_file_with_fd (fd);
-  if (file == NULL || file_length (file) == 0) {
+  struct descriptor *desc = get_file_descriptor (fd);
+  if (desc == NULL) {
     return MAP_FAILED;
   }
 
+  mapid_t mapping_id = MAP_FAILED;
+  if (file_length (desc->file) > 0)
+    mapping_id = map_file (desc->file, addr);
+  put_descriptor (desc);
+  return mapping_id;
+}
+
+/* Maps non-empty FILE at page aligned ADDR in the current process.
+   Returns the id of the mapping, or MAP_FAILED if it would overlap
+   pages that are already mapped. */
+static mapid_t
+map_file (struct file *file, void *addr)
+{
   int length = file_length (file);
-  struct thread *cur = thread_current ();
+  struct thread *cur = process_current ();
 
   /* Checks that the range of pages mapped 
      does not overlap any existing segment */
+  lock_acquire (&cur->vm_lock);
   int check_bytes = 0;
   void *check_addr = addr;
   while (check_bytes < length) {
     struct spte *spte = spt_find (cur->spt, check_addr);
     if (spte != NULL) {
+      lock_release (&cur->vm_lock);
       return MAP_FAILED;
     }
     check_bytes += PGSIZE;
@@ -336,6 +534,7 @@ mmap (int fd, void *addr)
   mmapped_file->file = file;
   mmapped_file->addr = start_addr;
   hash_insert (&cur->mmapped_file_table, &mmapped_file->elem);
+  lock_release (&cur->vm_lock);
 
   return mmapped_file->mapping_id;
 }
@@ -344,12 +543,14 @@ void
 munmap (mapid_t map_id)
 {
   /* Find the file mapping using map_id in process's table */
-  struct thread *cur = thread_current ();
+  struct thread *cur = process_current ();
   struct mmapped_file toFind;
   toFind.mapping_id = map_id;
+  lock_acquire (&cur->vm_lock);
   struct hash_elem *e = hash_find (&cur->mmapped_file_table, &toFind.elem);
 
   if (e == NULL) {
+    lock_release (&cur->vm_lock);
     return;
   }
 
@@ -361,6 +562,9 @@ munmap (mapid_t map_id)
   int length = file_length (file);
   int current_byte = 0;
 
+  /* Write back the dirty pages before they are unmapped */
+  write_back_range (addr, (uint8_t *) addr + length);
+
   /* Iterate over the pages of the mapped file */
   while (current_byte < length) {
     struct spte *spte = spt_find (cur->spt, addr);
@@ -370,17 +574,7 @@ munmap (mapid_t map_id)
 
     if (spte->value != NULL) {
       /* Still in frame, haven't been evicted */
-      /* Write back to the file if the mapped page is dirty */
-      if (pagedir_is_dirty (cur->pagedir, addr)) {
-        lock_acquire (&filesys_lock);
-        file_seek (file, spte->file_ofs);
-        file_write (file, spte->value, spte->bytes_read);
-        lock_release (&filesys_lock);
-      }
-      
-      /* Free resources */
-      palloc_free_page (pagedir_get_page (cur->pagedir, addr));
-      pagedir_clear_page (cur->pagedir, addr);
+      page_cache_unmap (spte);
     }
     spt_remove_entry (cur->spt, &spte->elem);
     free (spte);
@@ -391,108 +585,818 @@ munmap (mapid_t map_id)
 
   /* Remove the mapping from the process's table */
   hash_delete (&cur->mmapped_file_table, &mmapped_file->elem);
+  lock_release (&cur->vm_lock);
   free (mmapped_file);
 }
 
+/* Limits the current process to PAGES resident pages, or lifts the
+   limit if PAGES is 0. Children started afterwards inherit it.
+   A process at its limit evicts its own pages to make room.
+   Only frames the process owns count: page cache frames, which back
+   its file mappings and copy-on-write read () buffers, are shared
+   with other processes and count towards neither this limit nor the
+   out-of-memory killer's footprint. */
+bool
+set_rss_limit (int pages)
+{
+  if (pages < 0)
+    return false;
+  process_current ()->rss_limit = pages;
+  return true;
+}
+
+/* Returns true if [ADDR, ADDR + LENGTH) is page aligned and every
+   page in it is mapped by the current process. */
+static bool
+is_mapped_range (void *addr, size_t length)
+{
+  struct thread *cur = thread_current ();
+  uint8_t *start = addr;
+  uint8_t *end = start + length;
+
+  if (pg_ofs (start) != 0 || end < start || !is_user_vaddr (end - 1))
+    return false;
+
+  for (uint8_t *upage = start; upage < end; upage += PGSIZE) {
+    if (spt_find (cur->spt, upage) == NULL)
+      return false;
+  }
+  return true;
+}
+
+/* Calls FUNC on the supplemental page table entry of every page
+   in [ADDR, ADDR + LENGTH) of the current process. Returns -1
+   without calling FUNC if the range is not page aligned or not
+   entirely mapped, otherwise the number of pages for which FUNC
+   returned false. */
+static int
+for_each_page (void *addr, size_t length, bool (*func) (struct spte *, int),
+               int aux)
+{
+  struct thread *cur = thread_current ();
+
+  if (!is_mapped_range (addr, length))
+    return -1;
+
+  int failed = 0;
+  for (uint8_t *upage = addr; upage < (uint8_t *) addr + length;
+       upage += PGSIZE) {
+    if (!func (spt_find (cur->spt, upage), aux))
+      failed++;
+  }
+  return failed;
+}
+
+/* Writes the dirty, resident pages of file mappings in [START, END)
+   back to their files, straight from the cached frames that back
+   them so that no user memory is touched.  A page is dirty if any
+   process mapping it wrote to it; clean pages are skipped.
+   Must hold the process's vm_lock. */
+static void
+write_back_range (void *start, void *end)
+{
+  struct thread *cur = process_current ();
+
+  ASSERT (lock_held_by_current_thread (&cur->vm_lock));
+  for (uint8_t *upage = start; upage < (uint8_t *) end; upage += PGSIZE) {
+    struct spte *spte = spt_find (cur->spt, upage);
+    if (spte != NULL && spte->status == MMAP && spte->value != NULL)
+      page_cache_write_back (spte->value);
+  }
+}
+
+/* Writes the dirty pages of file mappings in [ADDR, ADDR + LENGTH)
+   back to their files. Returns 0 on success, -1 if the range is not
+   page aligned or not entirely mapped. */
+int
+msync (void *addr, size_t length)
+{
+  struct thread *process = process_current ();
+  lock_acquire (&process->vm_lock);
+  bool ok = is_mapped_range (addr, length);
+  if (ok)
+    write_back_range (addr, (uint8_t *) addr + length);
+  lock_release (&process->vm_lock);
+  return ok ? 0 : -1;
+}
+
+/* Applies madvise () hint ADVICE to SPTE. */
+static bool
+advise_page (struct spte *spte, int advice)
+{
+  switch (advice) {
+    case MADV_NORMAL:
+    case MADV_RANDOM:
+    case MADV_SEQUENTIAL:
+      spte->advice = advice;
+      return true;
+    case MADV_WILLNEED:
+      if (spte->status == SWAP
+          || (spte->status == MMAP && spte->value == NULL))
+        return page_in (spte);
+      return true;
+    case MADV_DONTNEED:
+      if (spte->status == MMAP && spte->value != NULL) {
+        /* Other processes may map the same cached page, so only our
+           mapping goes, after writing the page back. */
+        write_back_range (spte->vaddr, (uint8_t *) spte->vaddr + PGSIZE);
+        page_cache_unmap (spte);
+      } else if (spte->status == FRAME && spte->value != NULL
+                 && !spte->is_shared && spte->cow == NULL)
+        return evict_user_frame (spte->value);
+      return true;
+    default:
+      return false;
+  }
+}
+
+/* Gives hint ADVICE about the use of [ADDR, ADDR + LENGTH):
+   MADV_RANDOM turns off read-ahead and large pages for file mapping
+   pages, MADV_SEQUENTIAL reads ahead of faults and lets the clock
+   reclaim pages read ahead first, MADV_NORMAL restores the default.
+   MADV_WILLNEED pages the range in.  MADV_DONTNEED writes back file
+   mapping pages and unmaps them from this process only; it moves
+   private anonymous pages to swap rather than discarding them, like
+   Linux's MADV_PAGEOUT, since the kernel does not tell zero-fill pages
+   from initialized data, so they keep their contents.
+   Returns 0 on success, -1 if the range is not page aligned or not
+   entirely mapped, or if the hint could not be applied. */
+int
+madvise (void *addr, size_t length, int advice)
+{
+  if (advice < MADV_NORMAL || advice > MADV_DONTNEED)
+    return -1;
+
+  struct thread *process = process_current ();
+  lock_acquire (&process->vm_lock);
+  bool ok = for_each_page (addr, length, advise_page, advice) == 0;
+  lock_release (&process->vm_lock);
+  return ok ? 0 : -1;
+}
+
+/* Reads SIZE bytes at position OFFSET of the file open as FD into
+   BUFFER, without using or moving the file position.  Returns the
+   number of bytes actually read, or -1 if FD is not an open file or
+   OFFSET is negative. */
+int
+pread (int fd, void *buffer, unsigned size, int offset)
+{
+  if (offset < 0)
+    return -1;
+  struct descriptor *desc = get_file_descriptor (fd);
+  if (desc == NULL)
+    return -1;
+  int bytes_read = file_read_at (desc->file, buffer, size, offset);
+  put_descriptor (desc);
+  return bytes_read;
+}
+
+/* Writes SIZE bytes from BUFFER at position OFFSET of the file open
+   as FD, without using or moving the file position.  Returns the
+   number of bytes actually written, or -1 if FD is not an open file
+   or OFFSET is negative. */
+int
+pwrite (int fd, const void *buffer, unsigned size, int offset)
+{
+  if (offset < 0)
+    return -1;
+  struct descriptor *desc = get_file_descriptor (fd);
+  if (desc == NULL)
+    return -1;
+  int bytes_written = file_write_at (desc->file, buffer, size, offset);
+  put_descriptor (desc);
+  return bytes_written;
+}
+
+/* Copies the IOVCNT iovecs at user address UIOV into IOV, then checks
+   that every buffer they describe can be read, and written too if
+   WRITE is true.  Terminates the process if not.  Returns false if
+   IOVCNT is out of range. */
+static bool
+get_iovecs (struct iovec *iov, const struct iovec *uiov, int iovcnt,
+            bool write)
+{
+  if (iovcnt < 0 || iovcnt > IOV_MAX)
+    return false;
+  if (!copy_from_user (iov, uiov, iovcnt * sizeof *iov))
+    exit (-1);
+  for (int i = 0; i < iovcnt; i++)
+    check_buffer (iov[i].iov_base, iov[i].iov_len, write);
+  return true;
+}
+
+/* Reads from FD into the IOVCNT buffers described by IOV, filling
+   each one before moving to the next, as if by one read () per
+   buffer.  Stops at end of file.  Returns the number of bytes read,
+   or -1 if FD cannot be read or IOVCNT is more than IOV_MAX. */
+int
+readv (int fd, const struct iovec *uiov, int iovcnt)
+{
+  struct iovec iov[IOV_MAX];
+  int total = 0;
+
+  if (!get_iovecs (iov, uiov, iovcnt, true))
+    return -1;
+  for (int i = 0; i < iovcnt; i++) {
+    int bytes_read = read (fd, iov[i].iov_base, iov[i].iov_len);
+    if (bytes_read < 0)
+      return total > 0 ? total : -1;
+    total += bytes_read;
+    if ((size_t) bytes_read < iov[i].iov_len)
+      break;
+  }
+  return total;
+}
+
+/* Writes the IOVCNT buffers described by IOV to FD, in order, as if
+   by one write () per buffer.  Returns the number of bytes written,
+   or -1 if FD cannot be written or IOVCNT is more than IOV_MAX. */
+int
+writev (int fd, const struct iovec *uiov, int iovcnt)
+{
+  struct iovec iov[IOV_MAX];
+  int total = 0;
+
+  if (!get_iovecs (iov, uiov, iovcnt, false))
+    return -1;
+  for (int i = 0; i < iovcnt; i++) {
+    int bytes_written = write (fd, iov[i].iov_base, iov[i].iov_len);
+    if (bytes_written < 0)
+      return total > 0 ? total : -1;
+    total += bytes_written;
+    if ((size_t) bytes_written < iov[i].iov_len)
+      break;
+  }
+  return total;
+}
+
+/* Copies up to LENGTH bytes from the file open as IN_FD, starting at
+   its file position, to OUT_FD, which may be the console.  The data
+   goes through a kernel page, never through user memory.  OUT_FD must
+   be a file or the console.  Both file
+   positions advance by the number of bytes copied, which is returned;
+   it is less than LENGTH only at the end of IN_FD or when OUT_FD
+   cannot grow.  Returns -1 if either fd cannot be used. */
+int
+copy_file_range (int in_fd, int out_fd, unsigned length)
+{
+  struct descriptor *in_desc = get_file_descriptor (in_fd);
+  struct descriptor *out_desc = get_descriptor (out_fd);
+  void *buffer = NULL;
+  int total = -1;
+  if (in_desc == NULL || out_desc == NULL
+      || (out_desc->type != DESC_FILE && out_desc->type != DESC_CONSOLE_OUT))
+    goto done;
+  buffer = palloc_get_page (0);
+  if (buffer == NULL)
+    goto done;
+
+  struct file *in = in_desc->file;
+  struct file *out = out_desc->type == DESC_FILE ? out_desc->file : NULL;
+  total = 0;
+  while ((unsigned) total < length) {
+    off_t chunk = length - total < PGSIZE ? length - total : PGSIZE;
+    off_t bytes_read = file_read (in, buffer, chunk);
+    if (bytes_read == 0)
+      break;
+
+    off_t bytes_written = bytes_read;
+    if (out == NULL)
+      putbuf (buffer, bytes_read);
+    else
+      bytes_written = file_write (out, buffer, bytes_read);
+    total += bytes_written;
+    if (bytes_written < bytes_read) {
+      /* Leave IN_FD just after the last byte that made it out. */
+      file_seek (in, file_tell (in) - (bytes_read - bytes_written));
+      break;
+    }
+    if (bytes_read < chunk)
+      break;
+  }
+
+ done:
+  palloc_free_page (buffer);
+  put_descriptor (in_desc);
+  put_descriptor (out_desc);
+  return total;
+}
+
+/* Starts reading LENGTH bytes at position OFFSET of the file open as
+   FD into BUFFER, and returns without waiting for the disk.  Returns
+   an id for aio_wait () and aio_poll (), which complete the read, or
+   -1 if FD is not an open file or the read cannot be started. */
+int
+aio_read (int fd, void *buffer, unsigned length, int offset)
+{
+  struct descriptor *desc = get_file_descriptor (fd);
+  if (desc == NULL)
+    return -1;
+  int id = aio_submit (desc->file, false, buffer, length, offset);
+  put_descriptor (desc);
+  return id;
+}
+
+/* Starts writing LENGTH bytes from BUFFER at position OFFSET of the
+   file open as FD, and returns without waiting for the disk.  BUFFER
+   may be reused at once.  Returns an id for aio_wait () and
+   aio_poll (), or -1 if the write cannot be started. */
+int
+aio_write (int fd, const void *buffer, unsigned length, int offset)
+{
+  struct descriptor *desc = get_file_descriptor (fd);
+  if (desc == NULL)
+    return -1;
+  int id = aio_submit (desc->file, true, (void *) buffer, length, offset);
+  put_descriptor (desc);
+  return id;
+}
+
+/* Waits for the asynchronous read or write ID to finish.  Returns the
+   number of bytes it transferred, or -1 if ID is not a request of the
+   process.  Every id can be waited for, or polled to completion, once. */
+int
+aio_wait (int id)
+{
+  return aio_collect (id, true);
+}
+
+/* Like aio_wait (), but returns AIO_PENDING at once if request ID is
+   still in progress. */
+int
+aio_poll (int id)
+{
+  return aio_collect (id, false);
+}
+
+/* Creates a pipe and stores the fd of its read end in FDS[0] and that
+   of its write end in FDS[1].  Returns false if the pipe cannot be
+   created. */
+bool
+pipe (int fds[2])
+{
+  struct fd_table *fd_table = thread_current ()->fd_table;
+  struct pipe *pipe = pipe_create ();
+  if (pipe == NULL)
+    return false;
+
+  struct descriptor *read_end = descriptor_create (DESC_PIPE_READ, NULL, pipe);
+  struct descriptor *write_end = descriptor_create (DESC_PIPE_WRITE, NULL,
+                                                    pipe);
+  int kfds[2] = { -1, -1 };
+  if (read_end != NULL && write_end != NULL) {
+    kfds[0] = fd_table_insert (fd_table, read_end);
+    kfds[1] = fd_table_insert (fd_table, write_end);
+  }
+  if (kfds[0] < 0 || kfds[1] < 0) {
+    if (kfds[0] >= 0)
+      fd_table_remove (fd_table, kfds[0]);
+    if (kfds[1] >= 0)
+      fd_table_remove (fd_table, kfds[1]);
+    free (read_end);
+    free (write_end);
+    pipe_close_end (pipe, false);
+    pipe_close_end (pipe, true);
+    return false;
+  }
+
+  if (!copy_to_user (fds, kfds, sizeof kfds))
+    exit (-1);
+  return true;
+}
+
+/* Makes NEWFD refer to what OLDFD refers to, closing NEWFD first if it
+   is open.  Returns NEWFD, or -1 if OLDFD is not open or NEWFD is out
+   of range. */
+int
+dup2 (int oldfd, int newfd)
+{
+  struct fd_table *fd_table = thread_current ()->fd_table;
+  struct descriptor *desc = get_descriptor (oldfd);
+  if (desc == NULL)
+    return -1;
+  if (newfd < 0 || newfd >= FD_TABLE_MAX || oldfd == newfd) {
+    put_descriptor (desc);
+    return oldfd == newfd ? newfd : -1;
+  }
+
+  /* Unlike close (), replaces the console streams too. */
+  struct descriptor *old_desc = get_descriptor (newfd);
+  if (old_desc != NULL && (old_desc->type == DESC_CONSOLE_IN
+                           || old_desc->type == DESC_CONSOLE_OUT))
+    descriptor_release (fd_table, fd_table_remove (fd_table, newfd));
+  else
+    close (newfd);
+  put_descriptor (old_desc);
+
+  /* NEWFD takes over the reference get_descriptor () took. */
+  if (!fd_table_install (fd_table, newfd, desc)) {
+    put_descriptor (desc);
+    return -1;
+  }
+  return newfd;
+}
+
+/* Sets PFD->revents to the events PFD->events asks for that are ready
+   now, where DESC is the descriptor of PFD->fd, or NULL if it is not
+   open.  If ENTRY is not NULL, also adds it to the wait queue woken when
+   they may change, so that SEMA is upped then, unless they cannot
+   change.  Files and the console output are always ready. */
+static void
+poll_fd (struct pollfd *pfd, struct descriptor *desc,
+         struct wait_entry *entry, struct semaphore *sema)
+{
+  struct wait_queue *waiters = NULL;
+  short ready = 0;
+
+  pfd->revents = 0;
+  if (pfd->events & POLLAIO) {
+    /* An aio request may be collected and freed by another thread, so
+       its wait queue is only used under the aio lock. */
+    bool finished;
+    if (!aio_ready (pfd->fd, &finished, entry, sema))
+      pfd->revents = POLLNVAL;
+    else if (finished)
+      pfd->revents = POLLAIO;
+    return;
+  }
+
+  if (pfd->fd < 0)
+    return;
+  if (desc == NULL) {
+    pfd->revents = POLLNVAL;
+    return;
+  }
+  switch (desc->type) {
+    case DESC_CONSOLE_IN:
+      waiters = input_waiters ();
+      if (input_ready ())
+        ready = POLLIN;
+      break;
+    case DESC_PIPE_READ:
+    case DESC_PIPE_WRITE: {
+      bool writer = desc->type == DESC_PIPE_WRITE;
+      waiters = pipe_waiters (desc->pipe);
+      if (pipe_ready (desc->pipe, writer))
+        ready = writer ? POLLOUT : POLLIN;
+      break;
+    }
+    default:
+      ready = POLLIN | POLLOUT;
+      break;
+  }
+  pfd->revents = ready & pfd->events;
+  if (entry != NULL && waiters != NULL)
+    wait_queue_add (waiters, entry, sema);
+}
+
+/* Waits until one of the NFDS fds in FDS is ready for the events it
+   asks for, or for TIMEOUT milliseconds if TIMEOUT is positive, and
+   sets the events that are ready in each of them.  A TIMEOUT of 0
+   just checks, a negative one waits as long as it takes.  Returns the
+   number of fds with events, or -1 if NFDS is more than POLL_MAX.
+
+   The console input queue, pipes and aio requests each have a wait
+   queue, so the process sleeps until one of the fds it watches may
+   have become ready, or until it starts exiting, in which case it
+   returns 0. */
+int
+poll (struct pollfd *ufds, int nfds, int timeout)
+{
+  if (nfds < 0 || nfds > POLL_MAX)
+    return -1;
+
+  struct pollfd *fds = malloc (nfds * sizeof *fds);
+  struct wait_entry *entries = malloc (nfds * sizeof *entries);
+  struct descriptor **descs = malloc (nfds * sizeof *descs);
+  if (nfds > 0 && (fds == NULL || entries == NULL || descs == NULL)) {
+    free (fds);
+    free (entries);
+    free (descs);
+    return -1;
+  }
+  if (!copy_from_user (fds, ufds, nfds * sizeof *fds)) {
+    free (fds);
+    free (entries);
+    free (descs);
+    exit (-1);
+  }
+
+  /* Hold the descriptors until the entries are off their wait queues,
+     so that a pipe cannot be freed under them by a sibling thread
+     closing its fds. */
+  for (int i = 0; i < nfds; i++)
+    descs[i] = fds[i].fd >= 0 && !(fds[i].events & POLLAIO)
+               ? get_descriptor (fds[i].fd) : NULL;
+
+  struct semaphore wake;
+  struct thread_timer timer;
+  int64_t ticks = ((int64_t) timeout * TIMER_FREQ + 999) / 1000;
+  int64_t deadline = timer_ticks () + ticks;
+  sema_init (&wake, 0);
+  if (timeout > 0)
+    timer_start (&timer, ticks, &wake);
+
+  /* Add the entries before looking at the fds, so that an event in
+     between ups WAKE. */
+  struct wait_entry exit_entry;
+  process_add_exit_waiter (&exit_entry, &wake);
+  for (int i = 0; i < nfds; i++) {
+    entries[i].sema = NULL;
+    poll_fd (&fds[i], descs[i], &entries[i], &wake);
+  }
+
+  int ready_cnt;
+  for (;;) {
+    ready_cnt = 0;
+    for (int i = 0; i < nfds; i++) {
+      poll_fd (&fds[i], descs[i], NULL, NULL);
+      if (fds[i].revents != 0)
+        ready_cnt++;
+    }
+    if (ready_cnt > 0 || timeout == 0
+        || (timeout > 0 && timer_ticks () >= deadline))
+      break;
+    if (process_killed ())
+      break;
+    sema_down (&wake);
+  }
+
+  for (int i = 0; i < nfds; i++)
+    wait_queue_remove (&entries[i]);
+  for (int i = 0; i < nfds; i++)
+    put_descriptor (descs[i]);
+  wait_queue_remove (&exit_entry);
+  if (timeout > 0)
+    timer_cancel (&timer);
+
+  bool copied = copy_to_user (ufds, fds, nfds * sizeof *fds);
+  free (fds);
+  free (entries);
+  free (descs);
+  if (!copied)
+    exit (-1);
+  return ready_cnt;
+}
+
+/* Opens the shared memory segment called NAME, creating it with SIZE
+   zeroed bytes if it does not exist.  Returns a file descriptor that
+   mmap () maps like a file, except that every process mapping the
+   segment shares its pages, or -1 if it cannot be opened. */
+int
+shm_open (const char *name, unsigned size)
+{
+  lock_acquire (&filesys_lock);
+  struct inode *inode = shm_open_inode (name, size);
+  lock_release (&filesys_lock);
+  if (inode == NULL)
+    return -1;
+
+  struct file *file = file_open (inode);
+  struct descriptor *desc = descriptor_create (DESC_FILE, file, NULL);
+  int fd = -1;
+  if (file != NULL && desc != NULL)
+    fd = fd_table_insert (thread_current ()->fd_table, desc);
+  if (fd < 0) {
+    free (desc);
+    file_close (file);
+  }
+  return fd;
+}
+
+/* Removes the shared memory segment called NAME.  Processes that have
+   it open or mapped keep using it.  Returns false if there is no such
+   segment. */
+bool
+shm_unlink (const char *name)
+{
+  lock_acquire (&filesys_lock);
+  bool unlinked = shm_unlink_segment (name);
+  lock_release (&filesys_lock);
+  return unlinked;
+}
+
+/* Blocks until futex_wake () is called on the word at ADDR, unless
+   the word does not hold VAL.  Returns 0 after being woken, or -1 if
+   the word does not hold VAL or ADDR is not an aligned user word. */
+int
+futex_wait (int *addr, int val)
+{
+  return futex_sleep (addr, val);
+}
+
+/* Wakes up to N threads blocked in futex_wait () on the word at ADDR,
+   whichever process they are in.  Returns how many were woken. */
+int
+futex_wake (int *addr, int n)
+{
+  return futex_wakeup (addr, n);
+}
+
+/* Starts a thread of the current process that runs ENTRY (ARG) on the
+   stack that ends at STACK, see process_spawn_thread ().  Returns its
+   tid, or TID_ERROR if it cannot be started. */
+tid_t
+thread_spawn (void (*entry) (void *), void *arg, void *stack)
+{
+  return process_spawn_thread (entry, arg, stack);
+}
+
+/* Waits for thread TID of the current process to exit.  Returns 0, or
+   -1 if TID is not a thread that can be joined. */
+int
+thread_join (tid_t tid)
+{
+  return process_join_thread (tid);
+}
+
+/* Ends the calling thread, which lib/user/syscall.c does when the
+   function of a thread returns.  The main thread waits for the others
+   instead, then ends the process with status 0. */
+static void
+exit_thread (void)
+{
+  if (thread_current () != process_current ())
+    thread_exit ();
+  process_wait_threads ();
+  exit (0);
+}
+
+/* Registers RING, in the memory of the current process, as its
+   system call ring, replacing the previous one.  A null RING just
+   unregisters the previous one.  Returns false if RING is not
+   writable user memory. */
+bool
+ring_setup (struct syscall_ring *ring)
+{
+  if (ring != NULL && !check_user_buffer (ring, sizeof *ring, true))
+    return false;
+  process_current ()->ring = ring;
+  return true;
+}
+
+/* Carries out request SQE of a system call ring and returns the
+   result to post in its completion. */
+static int
+ring_dispatch (const struct ring_sqe *sqe)
+{
+  switch (sqe->op) {
+    case RING_READ:
+      if (!check_user_buffer (sqe->buffer, sqe->length, false)
+          || !is_writable_range (sqe->buffer, sqe->length))
+        return -1;
+      return read (sqe->fd, sqe->buffer, sqe->length);
+    case RING_WRITE:
+      if (!check_user_buffer (sqe->buffer, sqe->length, false))
+        return -1;
+      return write (sqe->fd, sqe->buffer, sqe->length);
+    case RING_SEEK:
+      seek (sqe->fd, sqe->length);
+      return 0;
+    default:
+      return -1;
+  }
+}
+
+/* Carries out the requests queued in the system call ring of the
+   current process, in order, posting a completion for each, until
+   the submission queue is empty or the completion queue is full.
+   Returns the number of requests carried out, or -1 if no ring is
+   registered.  Terminates the process if the ring itself cannot be
+   accessed. */
+int
+ring_enter (void)
+{
+  struct syscall_ring *ring = process_current ()->ring;
+  unsigned sq_head, sq_tail, cq_head, cq_tail;
+  int done = 0;
+
+  if (ring == NULL)
+    return -1;
+  if (!copy_from_user (&sq_head, &ring->sq_head, sizeof sq_head)
+      || !copy_from_user (&sq_tail, &ring->sq_tail, sizeof sq_tail)
+      || !copy_from_user (&cq_head, &ring->cq_head, sizeof cq_head)
+      || !copy_from_user (&cq_tail, &ring->cq_tail, sizeof cq_tail))
+    exit (-1);
+
+  while (sq_head != sq_tail && cq_tail - cq_head < RING_ENTRIES) {
+    struct ring_sqe sqe;
+    struct ring_cqe cqe;
+
+    if (!copy_from_user (&sqe, &ring->sq[sq_head % RING_ENTRIES], sizeof sqe))
+      exit (-1);
+    cqe.user_data = sqe.user_data;
+    cqe.result = ring_dispatch (&sqe);
+    if (!copy_to_user (&ring->cq[cq_tail % RING_ENTRIES], &cqe, sizeof cqe))
+      exit (-1);
+    sq_head++;
+    cq_tail++;
+    done++;
+  }
+
+  if (!copy_to_user (&ring->sq_head, &sq_head, sizeof sq_head)
+      || !copy_to_user (&ring->cq_tail, &cq_tail, sizeof cq_tail))
+    exit (-1);
+  return done;
+}
+
+/* Unmaps every file mapping of the current process, as if munmap
+   had been called on each of them. */
+static void
+munmap_all (void)
+{
+  struct hash *table = &process_current ()->mmapped_file_table;
+  while (!hash_empty (table)) {
+    struct hash_iterator it;
+    hash_first (&it, table);
+    hash_next (&it);
+    munmap (hash_entry (hash_cur (&it), struct mmapped_file, elem)->mapping_id);
+  }
+}
+
 /* Accesses the system call number from the user stack and perform actions
    based on the system call number. */
 static void
 syscall_handler (struct intr_frame *f)
 {
-  int *syscall_num = (int *) accessUserMemory (
-    thread_current ()->pagedir, f->esp);
+  int syscall_num;
+  int arg[MAX_ARGUMENT_NUMBER];
+  char *name;
+
   thread_current ()->esp = f->esp;
-  switch (*syscall_num) {
+  if (!copy_from_user (&syscall_num, f->esp, sizeof syscall_num))
+    exit (-1);
+  switch (syscall_num) {
     case SYS_HALT:
       halt ();
       break;
     case SYS_EXIT:
-      get_argument (f, 1);
-      exit (*arg[0]);
+      get_argument (f, arg, 1);
+      exit (arg[0]);
       break;
     case SYS_EXEC:
-      get_argument (f, 1);
-			f->eax = exec ((const char *) accessUserMemory (
-                                            thread_current ()->pagedir,
-                                            (const void *) *arg[0]
-                                          ));
-			break;
+      get_argument (f, arg, 1);
+      name = get_string ((const char *) arg[0]);
+      f->eax = exec (name);
+      palloc_free_page (name);
+      break;
     case SYS_WAIT:
-      get_argument (f, 1);
-      f->eax = wait (*arg[0]);
+      get_argument (f, arg, 1);
+      f->eax = wait (arg[0]);
       break;
     case SYS_CREATE:
-      get_argument (f, 2);
-      f->eax = create((const char *) accessUserMemory (
-                                              thread_current ()->pagedir,
-                                              (const void *) *arg[0]
-                                            ),
-                      (unsigned) *arg[1]);
+      get_argument (f, arg, 2);
+      name = get_string ((const char *) arg[0]);
+      f->eax = create (name, (unsigned) arg[1]);
+      palloc_free_page (name);
       break;
     case SYS_REMOVE:
-      get_argument (f, 1);
-      f->eax = remove((const char *) accessUserMemory (
-                                              thread_current ()->pagedir,
-                                              (const void *) *arg[0]
-                                            ));
-			break;
+      get_argument (f, arg, 1);
+      name = get_string ((const char *) arg[0]);
+      f->eax = remove (name);
+      palloc_free_page (name);
+      break;
     case SYS_OPEN:
-      get_argument (f, 1);
-      f->eax = open ((const char *) accessUserMemory (
-                                              thread_current ()->pagedir,
-                                              (const void *) *arg[0]
-                                            ));
+      get_argument (f, arg, 1);
+      name = get_string ((const char *) arg[0]);
+      f->eax = open (name);
+      palloc_free_page (name);
       break;
     case SYS_FILESIZE:
-      get_argument (f, 1);
-      f->eax = filesize (*arg[0]);
+      get_argument (f, arg, 1);
+      f->eax = filesize (arg[0]);
       break;
     case SYS_READ:
-      get_argument (f, 3);
-      f->eax = read (
-                     *arg[0],
-                     accessUserMemory (
-                                thread_current ()->pagedir,
-                                (const void *) *arg[1]
-                           ),
-                     *arg[2]
-                  );
+      get_argument (f, arg, 3);
+      check_buffer ((void *) arg[1], arg[2], true);
+      f->eax = read (arg[0], (void *) arg[1], arg[2]);
       break;
     case SYS_WRITE:
-      get_argument (f, 3);
-      f->eax = write (
-                  *arg[0],
-                  accessUserMemory (
-                            thread_current ()->pagedir,
-                            (const void *) *arg[1]
-                          ),
-                  *arg[2]
-                );
+      get_argument (f, arg, 3);
+      check_buffer ((const void *) arg[1], arg[2], false);
+      f->eax = write (arg[0], (const void *) arg[1], arg[2]);
       break;
     case SYS_SEEK:
-      get_argument (f, 2);
-      seek (*arg[0], (unsigned) *arg[1]);
+      get_argument (f, arg, 2);
+      seek (arg[0], (unsigned) arg[1]);
       break;
     case SYS_TELL:
-      get_argument (f, 1);
-      f->eax = tell (*arg[0]);
+      get_argument (f, arg, 1);
+      f->eax = tell (arg[0]);
       break;
     case SYS_CLOSE:
-      get_argument (f, 1);
-      close (*arg[0]);
+      get_argument (f, arg, 1);
+      close (arg[0]);
       break;
 
     /* The rest are not implemented for task 2 */
     case SYS_MMAP:
-      get_argument (f, 2);
-      f->eax = mmap (
-                  *arg[0],
-                  (void *) *arg[1]
-                    );
+      get_argument (f, arg, 2);
+      f->eax = mmap (arg[0], (void *) arg[1]);
       break;
     case SYS_MUNMAP:
-      get_argument (f, 1);
-      munmap (*arg[0]);
+      get_argument (f, arg, 1);
+      munmap (arg[0]);
       break;
     case SYS_CHDIR:
       break;
@@ -504,25 +1408,158 @@ syscall_handler (struct intr_frame *f)
       break;
     case SYS_INUMBER:
       break;
+    case SYS_SET_RSS_LIMIT:
+      get_argument (f, arg, 1);
+      f->eax = set_rss_limit (arg[0]);
+      break;
+    case SYS_MSYNC:
+      get_argument (f, arg, 2);
+      f->eax = msync ((void *) arg[0], (size_t) arg[1]);
+      break;
+    case SYS_MADVISE:
+      get_argument (f, arg, 3);
+      f->eax = madvise ((void *) arg[0], (size_t) arg[1], arg[2]);
+      break;
+    case SYS_PREAD:
+      get_argument (f, arg, 4);
+      check_buffer ((void *) arg[1], arg[2], true);
+      f->eax = pread (arg[0], (void *) arg[1], arg[2], arg[3]);
+      break;
+    case SYS_PWRITE:
+      get_argument (f, arg, 4);
+      check_buffer ((const void *) arg[1], arg[2], false);
+      f->eax = pwrite (arg[0], (const void *) arg[1], arg[2], arg[3]);
+      break;
+    case SYS_READV:
+      get_argument (f, arg, 3);
+      f->eax = readv (arg[0], (const struct iovec *) arg[1], arg[2]);
+      break;
+    case SYS_WRITEV:
+      get_argument (f, arg, 3);
+      f->eax = writev (arg[0], (const struct iovec *) arg[1], arg[2]);
+      break;
+    case SYS_COPY_FILE_RANGE:
+      get_argument (f, arg, 3);
+      f->eax = copy_file_range (arg[0], arg[1], arg[2]);
+      break;
+    case SYS_AIO_READ:
+      get_argument (f, arg, 4);
+      check_buffer ((void *) arg[1], arg[2], true);
+      f->eax = aio_read (arg[0], (void *) arg[1], arg[2], arg[3]);
+      break;
+    case SYS_AIO_WRITE:
+      get_argument (f, arg, 4);
+      check_buffer ((const void *) arg[1], arg[2], false);
+      f->eax = aio_write (arg[0], (const void *) arg[1], arg[2], arg[3]);
+      break;
+    case SYS_AIO_WAIT:
+      get_argument (f, arg, 1);
+      f->eax = aio_wait (arg[0]);
+      break;
+    case SYS_AIO_POLL:
+      get_argument (f, arg, 1);
+      f->eax = aio_poll (arg[0]);
+      break;
+    case SYS_PIPE:
+      get_argument (f, arg, 1);
+      f->eax = pipe ((int *) arg[0]);
+      break;
+    case SYS_DUP2:
+      get_argument (f, arg, 2);
+      f->eax = dup2 (arg[0], arg[1]);
+      break;
+    case SYS_POLL:
+      get_argument (f, arg, 3);
+      f->eax = poll ((struct pollfd *) arg[0], arg[1], arg[2]);
+      break;
+    case SYS_SHM_OPEN:
+      get_argument (f, arg, 2);
+      name = get_string ((const char *) arg[0]);
+      f->eax = shm_open (name, arg[1]);
+      palloc_free_page (name);
+      break;
+    case SYS_SHM_UNLINK:
+      get_argument (f, arg, 1);
+      name = get_string ((const char *) arg[0]);
+      f->eax = shm_unlink (name);
+      palloc_free_page (name);
+      break;
+    case SYS_FUTEX_WAIT:
+      get_argument (f, arg, 2);
+      f->eax = futex_wait ((int *) arg[0], arg[1]);
+      break;
+    case SYS_FUTEX_WAKE:
+      get_argument (f, arg, 2);
+      f->eax = futex_wake ((int *) arg[0], arg[1]);
+      break;
+    case SYS_THREAD_SPAWN:
+      get_argument (f, arg, 3);
+      f->eax = thread_spawn ((void (*) (void *)) arg[0], (void *) arg[1],
+                             (void *) arg[2]);
+      break;
+    case SYS_THREAD_JOIN:
+      get_argument (f, arg, 1);
+      f->eax = thread_join (arg[0]);
+      break;
+    case SYS_THREAD_EXIT:
+      exit_thread ();
+      break;
+    case SYS_RING_SETUP:
+      get_argument (f, arg, 1);
+      f->eax = ring_setup ((struct syscall_ring *) arg[0]);
+      break;
+    case SYS_RING_ENTER:
+      f->eax = ring_enter ();
+      break;
     default:
       exit (-1);
   }
 }
 
-/* Checks to ensure that the user virtual address is valid and returns the
-   kernel virtual address corresponding to that user virtual address. If the
-   user virtual address is invalid, the process will be terminated and its
-   resources will be freed. */
-static void *
-accessUserMemory (uint32_t *pd, const void *uaddr)
+/* Copies the string at user address USTR into a new page, which the
+   caller must free with palloc_free_page ().  Terminates the process
+   if the string is not readable.  Strings longer than a page are
+   truncated. */
+static char *
+get_string (const char *ustr)
 {
-  void *kernel_vaddr;
-  if (uaddr == NULL || !is_user_vaddr (uaddr)
-      || (kernel_vaddr = pagedir_get_page (pd, uaddr)) == NULL) {
-    
+  char *str = palloc_get_page (0);
+  if (str == NULL)
     exit (-1);
-    return NULL;
-  } else {
-    return kernel_vaddr;
+  if (!copy_string_from_user (str, ustr, PGSIZE)) {
+    palloc_free_page (str);
+    exit (-1);
+  }
+  return str;
+}
+
+/* Terminates the process unless all of the SIZE bytes at user address
+   UBUF can be read, and written too if WRITE is true. */
+static void
+check_buffer (const void *ubuf, unsigned size, bool write)
+{
+  if (!check_user_buffer (ubuf, size, false)
+      || (write && !is_writable_range (ubuf, size)))
+    exit (-1);
+}
+
+/* Returns true if every page of [UBUF, UBUF + SIZE) may be written,
+   which the caller has already checked to be mapped.  Looks the pages
+   up instead of writing to them, which would give pages that read ()
+   mapped copy-on-write a private copy on every read into them. */
+static bool
+is_writable_range (const void *ubuf, unsigned size)
+{
+  struct thread *process = process_current ();
+  uint8_t *end = (uint8_t *) ubuf + size;
+  bool ok = true;
+
+  lock_acquire (&process->vm_lock);
+  for (uint8_t *upage = pg_round_down (ubuf); upage < end && ok;
+       upage += PGSIZE) {
+    struct spte *spte = spt_find (process->spt, upage);
+    ok = spte != NULL && spte->writable;
   }
+  lock_release (&process->vm_lock);
+  return ok;
 }
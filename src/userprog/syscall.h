@@ -5,7 +5,7 @@
 
 typedef int pid_t;
 #define PID_ERROR ((pid_t) -1)
-#define MAX_ARGUMENT_NUMBER 3
+#define MAX_ARGUMENT_NUMBER 4
 #define EOF (-1)
 
 void syscall_init (void);
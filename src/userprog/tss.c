@@ -104,3 +104,12 @@ tss_update (void)
   ASSERT (tss != NULL);
   tss->esp0 = (uint8_t *) thread_current () + PGSIZE;
 }
+
+/* Returns the address of the ring 0 stack pointer in the TSS, where
+   SYSENTER finds the kernel stack of the current thread. */
+void **
+tss_esp0 (void)
+{
+  ASSERT (tss != NULL);
+  return &tss->esp0;
+}
@@ -0,0 +1,146 @@
+#include "userprog/uaccess.h"
+#include "threads/vaddr.h"
+
+/* Bounds of the exception table, set by the linker script. */
+extern const struct exception_entry __start_ex_table[];
+extern const struct exception_entry __stop_ex_table[];
+
+/* Adds an entry to the exception table, for use in inline assembly:
+   a fault at local label INSN resumes at local label FIXUP. */
+#define EX_TABLE(INSN, FIXUP)                                   \
+        ".pushsection __ex_table, \"a\"\n"                      \
+        ".long " INSN ", " FIXUP "\n"                           \
+        ".popsection\n"
+
+/* Returns the fixup address for a fault at INSN, or 0 if INSN is not
+   in the exception table. */
+uintptr_t
+search_exception_table (uintptr_t insn)
+{
+  const struct exception_entry *e;
+
+  for (e = __start_ex_table; e < __stop_ex_table; e++)
+    if (e->insn == insn)
+      return e->fixup;
+  return 0;
+}
+
+/* Returns true if [UADDR, UADDR + SIZE) lies entirely in user
+   virtual memory. */
+static bool
+is_user_range (const void *uaddr, size_t size)
+{
+  uintptr_t start = (uintptr_t) uaddr;
+  return start + size >= start && start + size <= (uintptr_t) PHYS_BASE;
+}
+
+/* Copies SIZE bytes from SRC to DST, where one of them is in user
+   memory.  Faults are handled by page_fault () as usual, so lazily
+   loaded and swapped out pages are brought in on the way.  Returns
+   false if a fault could not be resolved. */
+static bool
+copy_user (void *dst, const void *src, size_t size)
+{
+  int ok;
+
+  asm volatile ("movl $1, %0\n"
+                "1: rep movsb\n"
+                "jmp 3f\n"
+                "2: movl $0, %0\n"
+                "3:\n"
+                EX_TABLE ("1b", "2b")
+                : "=&a" (ok), "+D" (dst), "+S" (src), "+c" (size)
+                : : "memory");
+  return ok;
+}
+
+/* Reads the byte at user address UADDR.  Returns false if it cannot
+   be read. */
+static bool
+probe_read (const uint8_t *uaddr)
+{
+  int ok;
+
+  asm volatile ("movl $1, %0\n"
+                "1: testb $0, %1\n"
+                "jmp 3f\n"
+                "2: movl $0, %0\n"
+                "3:\n"
+                EX_TABLE ("1b", "2b")
+                : "=&a" (ok) : "m" (*uaddr));
+  return ok;
+}
+
+/* Writes the byte at user address UADDR without changing it, which
+   gives a copy-on-write page a private copy.  Returns false if it
+   cannot be written. */
+static bool
+probe_write (uint8_t *uaddr)
+{
+  int ok;
+
+  asm volatile ("movl $1, %0\n"
+                "1: lock orb $0, %1\n"
+                "jmp 3f\n"
+                "2: movl $0, %0\n"
+                "3:\n"
+                EX_TABLE ("1b", "2b")
+                : "=&a" (ok), "+m" (*uaddr));
+  return ok;
+}
+
+/* Copies SIZE bytes from user address USRC to DST.  Returns false if
+   any of them is not readable user memory. */
+bool
+copy_from_user (void *dst, const void *usrc, size_t size)
+{
+  return is_user_range (usrc, size) && copy_user (dst, usrc, size);
+}
+
+/* Copies SIZE bytes from SRC to user address UDST.  Returns false if
+   any of them is not writable user memory. */
+bool
+copy_to_user (void *udst, const void *src, size_t size)
+{
+  return is_user_range (udst, size) && copy_user (udst, src, size);
+}
+
+/* Copies the null-terminated string at user address USRC into DST,
+   truncating it to SIZE - 1 characters.  Returns false if any byte up
+   to the null terminator or the truncation point is not readable
+   user memory. */
+bool
+copy_string_from_user (char *dst, const char *usrc, size_t size)
+{
+  size_t i;
+
+  if (size == 0)
+    return true;
+  for (i = 0; i + 1 < size; i++) {
+    if (!copy_from_user (dst + i, usrc + i, 1))
+      return false;
+    if (dst[i] == '\0')
+      return true;
+  }
+  dst[i] = '\0';
+  return true;
+}
+
+/* Returns true if all of [UBUF, UBUF + SIZE) is user memory that can
+   be read, and written too if WRITE is true.  Touches every page of
+   the buffer once, so that pages that are not loaded yet or swapped
+   out are brought in before the kernel works on the buffer. */
+bool
+check_user_buffer (const void *ubuf, size_t size, bool write)
+{
+  uint8_t *start = (uint8_t *) ubuf;
+  uint8_t *end = start + size;
+  uint8_t *p;
+
+  if (!is_user_range (ubuf, size))
+    return false;
+  for (p = start; p < end; p = pg_round_down (p) + PGSIZE)
+    if (!(write ? probe_write (p) : probe_read (p)))
+      return false;
+  return true;
+}
@@ -0,0 +1,24 @@
+#ifndef USERPROG_UACCESS_H
+#define USERPROG_UACCESS_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Entry of the exception table.  A page fault at INSN that the page
+   fault handler cannot resolve makes the kernel resume at FIXUP
+   instead of killing the process.  Entries are put in the __ex_table
+   section, see threads/kernel.lds.S. */
+struct exception_entry {
+  uintptr_t insn;                     /* Address of a faulting instruction. */
+  uintptr_t fixup;                    /* Where to resume after a fault. */
+};
+
+uintptr_t search_exception_table (uintptr_t insn);
+
+bool copy_from_user (void *dst, const void *usrc, size_t size);
+bool copy_to_user (void *udst, const void *src, size_t size);
+bool copy_string_from_user (char *dst, const char *usrc, size_t size);
+bool check_user_buffer (const void *ubuf, size_t size, bool write);
+
+#endif /* userprog/uaccess.h */
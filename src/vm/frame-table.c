@@ -1,15 +1,20 @@
+#include <stdio.h>
+#include <string.h>
 #include "../devices/swap.h"
+#include "../devices/timer.h"
+#include "../threads/interrupt.h"
 #include "../threads/palloc.h"
 #include "../threads/loader.h"
 #include "../threads/vaddr.h"
 #include "../threads/synch.h"
 #include "../userprog/pagedir.h"
+#include "../userprog/process.h"
 #include "../lib/debug.h"
 #include "../lib/kernel/bitmap.h"
 #include "../threads/pte.h"
 #include "frame-table.h"
-#include "filesys/filesys.h"
-#include "filesys/file.h"
+#include "same-page.h"
+#include "page-cache.h"
 
 struct FrameTable {
   void *user_pool_base;
@@ -17,10 +22,14 @@ struct FrameTable {
   struct Frame *frames;         /* A list of frames. */
 } frame_table;
 
-struct lock eviction_lock;
-struct lock frame_table_lock;
+bool large_user_pages;
 
-int get_user_frame_number (void *kernel_page);
+/* Timer ticks to wait for a process chosen by the out-of-memory
+   killer to exit before choosing another one. */
+#define OOM_KILL_WAIT 100
+
+/* When the last out-of-memory kill happened. */
+static int64_t oom_kill_time;
 
 /* Init the frame table based on user_pool_base and user_pool_page_count. */
 void frame_table_init (void *user_pool_base, uint32_t user_pool_page_count)
@@ -44,13 +53,77 @@ int get_user_frame_number (void *kernel_page)
   return ((char *) kernel_page - (char *) frame_table.user_pool_base) >> PGBITS;
 }
 
+/* Returns the number of frames in the user pool. */
+uint32_t frame_table_size (void)
+{
+  return frame_table.user_pool_page_count;
+}
+
+/* Returns the frame table entry of frame FRAME_NO. */
+Frame *frame_table_get (uint32_t frame_no)
+{
+  ASSERT (frame_no < frame_table.user_pool_page_count);
+  return &frame_table.frames[frame_no];
+}
+
+/* Returns the kernel virtual address of frame FRAME_NO. */
+void *frame_table_kernel_page (uint32_t frame_no)
+{
+  ASSERT (frame_no < frame_table.user_pool_page_count);
+  return (char *) frame_table.user_pool_base + (frame_no << PGBITS);
+}
+
+/* Records OWNER as the owner of FRAME, which holds the page of OWNER
+   described by SPTE, moving FRAME from the previous owner's frames
+   list to OWNER's.  OWNER and SPTE are NULL for a frame that is no
+   longer in use.  Keeping SPTE here spares the eviction and merging
+   code lookups in page tables of other processes.
+   Must hold frame_table_lock. */
+void frame_set_owner (Frame *frame, struct thread *owner, struct spte *spte)
+{
+  if (frame->owner != NULL) {
+    list_remove (&frame->owner_elem);
+    frame->owner->resident_pages--;
+  }
+  frame->owner = owner;
+  frame->spte = spte;
+  frame->user_page = spte != NULL ? spte->vaddr : NULL;
+  if (owner != NULL) {
+    list_push_back (&owner->frames, &frame->owner_elem);
+    owner->resident_pages++;
+  }
+}
+
+/* Records that FRAME holds the cached file page CACHED, or no longer
+   does if CACHED is NULL. Cached frames have no owner, they are
+   evicted through the page cache. */
+void frame_set_cached (void *kernel_page, struct cache_page *cached)
+{
+  lock_acquire (&frame_table_lock);
+  Frame *frame = &frame_table.frames[get_user_frame_number (kernel_page)];
+  frame->cached = cached;
+  frame->r = true;
+  frame->checksum = 0;
+  frame->merged = NULL;
+  lock_release (&frame_table_lock);
+}
+
 /* Evict a frame based on clock algorithm. */
 static uint32_t choose_frame_to_evict (void)
 {
   // Using clock algorithm
   static uint32_t hand = 0;
   while (true) {
-    if (frame_table.frames[hand].r) {
+    if ((frame_table.frames[hand].owner == NULL
+         && frame_table.frames[hand].cached == NULL)
+        || frame_table.frames[hand].merged != NULL) {
+      // Unowned frames outside of the page cache are being set up,
+      // merged frames are mapped by several pages, so neither can be
+      // evicted
+      hand += 1;
+      if (hand == frame_table.user_pool_page_count)
+        hand = 0;
+    } else if (frame_table.frames[hand].r) {
       // Give a chance to frame with R = 1
       frame_table.frames[hand].r = false;
       // Hand returns to the beginning when it reaches the end
@@ -71,97 +144,303 @@ static uint32_t choose_frame_to_evict (void)
   }
 }
 
-/* Allocate a kernel page for a user page. */
-void *allocate_user_page (void *user_address, bool writable, bool zeroed)
+/* Choose one of THREAD's own frames to evict, with the same second
+   chance policy as the clock, using THREAD's frames list as the clock
+   face. Returns -1 if none of them can be evicted.
+   Must hold frame_table_lock. */
+static int choose_own_frame_to_evict (struct thread *thread)
+{
+  // Every frame is seen at most twice: once with R = 1, once with R = 0
+  size_t tries = 2 * list_size (&thread->frames);
+  while (tries-- > 0) {
+    struct list_elem *e = list_pop_front (&thread->frames);
+    list_push_back (&thread->frames, e);
+    Frame *frame = list_entry (e, Frame, owner_elem);
+    if (frame->merged != NULL)
+      continue;
+    if (frame->r)
+      frame->r = false;
+    else
+      return frame - frame_table.frames;
+  }
+  return -1;
+}
+
+/* Evicts frame EVICT_FRAME_NO. Returns false if it could not be freed
+   because swap is full. Must hold eviction_lock. */
+static bool evict_frame (uint32_t evict_frame_no)
+{
+  lock_acquire (&frame_table_lock);
+  struct thread *owner = frame_table.frames[evict_frame_no].owner;
+  void *user_page = frame_table.frames[evict_frame_no].user_page;
+  struct spte *spte = frame_table.frames[evict_frame_no].spte;
+  bool cached = frame_table.frames[evict_frame_no].cached != NULL;
+  lock_release (&frame_table_lock);
+
+  if (cached) {
+    /* File data is written back to its file, if dirty, and unmapped
+       from every process mapping it */
+    page_cache_evict (frame_table_kernel_page (evict_frame_no));
+    return true;
+  }
+
+  void *frame = pagedir_get_page (owner->pagedir, user_page);
+
+  // Try to write this frame to swap
+  bool writable = pagedir_is_writable (owner->pagedir, user_page);
+  bool dirty = pagedir_is_dirty (owner->pagedir, user_page);
+  pagedir_clear_page (owner->pagedir, user_page);
+  size_t swap_slot = swap_out (frame);
+  if (swap_slot == BITMAP_ERROR) {
+    // Swap is full, give the page back to its owner untouched
+    pagedir_set_page (owner->pagedir, user_page, frame, writable);
+    pagedir_set_dirty (owner->pagedir, user_page, dirty);
+    return false;
+  }
+  spte->status = SWAP;
+  spte->value = (void *) swap_slot;
+  owner->swap_pages++;
+
+  // Evict this frame from RAM
+  palloc_free_page (frame);
+
+  lock_acquire (&frame_table_lock);
+  frame_set_owner (&frame_table.frames[evict_frame_no], NULL, NULL);
+  lock_release (&frame_table_lock);
+  return true;
+}
+
+/* State of the search for an out-of-memory victim. */
+struct oom_search {
+  struct thread *victim;        /* Process with the largest footprint. */
+  size_t footprint;             /* Its resident plus swapped pages. */
+  bool pending;                 /* A previous victim has not exited yet. */
+};
+
+/* thread_foreach () callback that looks for an out-of-memory victim. */
+static void oom_search_thread (struct thread *t, void *aux)
+{
+  struct oom_search *search = aux;
+
+  if (t->pagedir == NULL || t->status == THREAD_DYING || t->process != t)
+    return;
+  if (t->oom_killed) {
+    search->pending = true;
+    return;
+  }
+
+  size_t footprint = t->resident_pages + t->swap_pages;
+  if (search->victim == NULL || footprint > search->footprint) {
+    search->victim = t;
+    search->footprint = footprint;
+  }
+}
+
+/* Called when the user pool and swap are both full. Chooses the
+   process using the most memory, counting both its resident and its
+   swapped pages, and marks it to be killed on its way back to user
+   mode. Waits a little instead if a previous victim is still exiting.
+   Returns false if the current process itself should give up. */
+static bool oom_kill (void)
 {
-  void *kernel_page = palloc_get_page (PAL_USER | (zeroed ? PAL_ZERO : 0));
-  if (kernel_page == NULL) {
+  struct thread *cur = process_current ();
+  struct oom_search search = { NULL, 0, false };
+  char name[sizeof cur->name];
+  tid_t tid;
+
+  if (cur->oom_killed)
+    return false;
+
+  enum intr_level old_level = intr_disable ();
+  thread_foreach (oom_search_thread, &search);
+  if (search.pending && timer_elapsed (oom_kill_time) < OOM_KILL_WAIT) {
+    intr_set_level (old_level);
+    timer_sleep (1);
+    return true;
+  }
+  if (search.victim == NULL) {
+    intr_set_level (old_level);
+    return false;
+  }
+  search.victim->oom_killed = true;
+  oom_kill_time = timer_ticks ();
+  strlcpy (name, search.victim->name, sizeof name);
+  tid = search.victim->tid;
+  intr_set_level (old_level);
+
+  printf ("Out of memory: killed process %d (%s), %zu pages\n",
+          tid, name, search.footprint);
+  return search.victim != cur;
+}
+
+/* Obtain a free frame from the user pool, evicting one if the pool
+   is full. The frame is not mapped nor recorded in the frame table.
+   Returns NULL if the current process was chosen by the out-of-memory
+   killer, in which case it should exit. */
+void *obtain_user_frame (bool zeroed)
+{
+  struct thread *cur = process_current ();
+
+  if (cur->rss_limit != 0 && cur->resident_pages >= cur->rss_limit) {
+    // Over its resident set limit, the process pays with its own pages
     lock_acquire (&eviction_lock);
+    lock_acquire (&frame_table_lock);
+    int evict_frame_no = choose_own_frame_to_evict (cur);
+    lock_release (&frame_table_lock);
+    if (evict_frame_no != -1)
+      evict_frame (evict_frame_no);
+    lock_release (&eviction_lock);
+  }
+
+  for (;;) {
+    void *kernel_page = palloc_get_page (PAL_USER | (zeroed ? PAL_ZERO : 0));
+    if (kernel_page != NULL)
+      return kernel_page;
 
     // User pool is full, so choose a frame to evict
+    lock_acquire (&eviction_lock);
     lock_acquire (&frame_table_lock);
     uint32_t evict_frame_no = choose_frame_to_evict ();
-    struct thread *owner = frame_table.frames[evict_frame_no].owner;
-    void *user_page = frame_table.frames[evict_frame_no].user_page;
     lock_release (&frame_table_lock);
+    bool evicted = evict_frame (evict_frame_no);
+    lock_release (&eviction_lock);
 
-    void *frame = pagedir_get_page (owner->pagedir, user_page);
-
-    struct spte *spte = spt_find (owner->spt, user_page);
-    if (spte->status == MMAP) {
-      /* Evicting a page mapped by mmap writes it back to the file it was
-      mapped from */
-      if (pagedir_is_dirty (owner->pagedir, user_page)) {
-        lock_acquire (&filesys_lock);
-        file_seek (spte->file, spte->file_ofs);
-        file_write (spte->file, spte->value, spte->bytes_read);
-        lock_release (&filesys_lock);
-      }
-      pagedir_clear_page (owner->pagedir, user_page);
-      palloc_free_page (frame);
-
-      /* Set value to NULL to detect that the frame has been evicted */
-      spte->value = NULL;
-    } else {
-      // Try to write this frame to swap
-      pagedir_clear_page (owner->pagedir, user_page);
-      size_t swap_slot = swap_out (frame);
-      if (swap_slot == BITMAP_ERROR) {
-        PANIC ("allocate_user_page: User pool is full. \
-                Swap is full. Cannot allocate more pages.");
-        return NULL;
-      }
-      spte->status = SWAP;
-      spte->value = (void *) swap_slot;
-
-      // Evict this frame from RAM
-      palloc_free_page (frame);
-
-    }
+    // Another thread may take the freed frame first, so try again
+    if (!evicted && !oom_kill ())
+      return NULL;
+  }
+}
 
-    // Now there must be a free frame
-    kernel_page = palloc_get_page (PAL_USER | (zeroed ? PAL_ZERO : 0));
-    ASSERT (kernel_page != NULL);
-    lock_release (&eviction_lock);
+/* Allocate a kernel page for a user page. */
+void *allocate_user_page (void *user_address, bool writable, bool zeroed)
+{
+  void *kernel_page = obtain_user_frame (zeroed);
+  if (kernel_page == NULL)
+    return NULL;
+  if (!install_user_frame (user_address, kernel_page, writable)) {
+    palloc_free_page (kernel_page);
+    return NULL;
   }
+  return kernel_page;
+}
 
-  struct thread *thread = thread_current ();
+/* Map KERNEL_PAGE, obtained by obtain_user_frame (), at USER_ADDRESS in
+   the current thread and record it in the frame table. */
+bool install_user_frame (void *user_address, void *kernel_page, bool writable)
+{
+  struct thread *thread = process_current ();
 
   /* Verify that there's not already a page at that virtual
      address, then map our page there. */
-  if (pagedir_get_page (thread->pagedir, user_address) != NULL) {
-    palloc_free_page (kernel_page);
-    return NULL;
-  }
+  if (pagedir_get_page (thread->pagedir, user_address) != NULL)
+    return false;
 
   if (!pagedir_set_page (thread->pagedir, 
-       user_address, kernel_page, writable)) {
-    palloc_free_page (kernel_page);
-    return NULL;
-  }
+       user_address, kernel_page, writable))
+    return false;
 
   int frame_number = get_user_frame_number (kernel_page);
 
   lock_acquire (&frame_table_lock);
-  frame_table.frames[frame_number].owner = thread;
-  frame_table.frames[frame_number].user_page = user_address;
+  frame_set_owner (&frame_table.frames[frame_number], thread,
+                   spt_find (thread->spt, user_address));
   frame_table.frames[frame_number].r = true;
+  frame_table.frames[frame_number].checksum = 0;
+  frame_table.frames[frame_number].merged = NULL;
   lock_release (&frame_table_lock);
 
-  return kernel_page;
+  return true;
 }
 
-/* Frees all user pages. */
-void free_all_user_pages (struct thread *thread)
+/* Maps KERNEL_PAGE, a user pool frame that nobody owns, at USER_PAGE
+   in the current thread in place of the frame mapped there, which is
+   returned and now owned by nobody.  This moves a page of data into
+   USER_PAGE without copying it.  Returns NULL, changing nothing, if
+   USER_PAGE is not a private, writable anonymous page that is present
+   right now. */
+void *swap_user_frame (void *user_page, void *kernel_page)
 {
-  uint32_t *page_directory = thread->pagedir;
+  struct thread *cur = process_current ();
+  struct spte *spte = spt_find (cur->spt, user_page);
+  void *old_page = NULL;
+
+  if (spte == NULL || spte->status != FRAME || !spte->writable)
+    return NULL;
 
-  for (uint32_t i = 0; i < frame_table.user_pool_page_count; i++) {
-    if (frame_table.frames[i].owner == thread) {
-      frame_table.frames[i].owner = NULL;
-      frame_table.frames[i].user_page = NULL;
+  /* Keep the old frame from being evicted while it is replaced. */
+  lock_acquire (&eviction_lock);
+  lock_acquire (&frame_table_lock);
+  void *page = pagedir_get_page (cur->pagedir, user_page);
+  if (page != NULL && !spte->is_shared && spte->cow == NULL
+      && pagedir_is_writable (cur->pagedir, user_page)) {
+    Frame *old_frame = &frame_table.frames[get_user_frame_number (page)];
+    Frame *new_frame
+      = &frame_table.frames[get_user_frame_number (kernel_page)];
+    if (old_frame->owner == cur && old_frame->merged == NULL
+        && old_frame->cached == NULL) {
+      pagedir_clear_page (cur->pagedir, user_page);
+      /* The page table of USER_PAGE exists, so this cannot fail. */
+      pagedir_set_page (cur->pagedir, user_page, kernel_page, true);
+      frame_set_owner (old_frame, NULL, NULL);
+      frame_set_owner (new_frame, cur, spte);
+      new_frame->r = true;
+      new_frame->checksum = 0;
+      new_frame->merged = NULL;
+      spte->value = kernel_page;
+      old_page = page;
     }
   }
+  lock_release (&frame_table_lock);
+  lock_release (&eviction_lock);
+  return old_page;
+}
+
+/* Evicts KERNEL_PAGE right away, as if the clock had chosen it.
+   Returns false if it is merged with other pages or if swap is full. */
+bool evict_user_frame (void *kernel_page)
+{
+  uint32_t frame_number = get_user_frame_number (kernel_page);
+  bool evicted = false;
+
+  lock_acquire (&eviction_lock);
+  lock_acquire (&frame_table_lock);
+  bool evictable = (frame_table.frames[frame_number].owner != NULL
+                    || frame_table.frames[frame_number].cached != NULL)
+                   && frame_table.frames[frame_number].merged == NULL;
+  lock_release (&frame_table_lock);
+  if (evictable)
+    evicted = evict_frame (frame_number);
+  lock_release (&eviction_lock);
+  return evicted;
+}
+
+/* Sets the R bit of KERNEL_PAGE to REFERENCED. The clock evicts a
+   frame whose R bit is clear the first time it comes across it. */
+void frame_set_referenced (void *kernel_page, bool referenced)
+{
+  lock_acquire (&frame_table_lock);
+  frame_table.frames[get_user_frame_number (kernel_page)].r = referenced;
+  lock_release (&frame_table_lock);
+}
+
+/* Frees all user pages of THREAD, whose page directory is PAGE_DIRECTORY.
+   THREAD's own pagedir member has already been cleared by process_exit (). */
+void free_all_user_pages (struct thread *thread, uint32_t *page_directory)
+{
+  /* Merged frames are still in use by other processes, and cached
+     frames by the page cache, so unmap them before the page directory
+     frees everything it maps. */
+  page_cache_release_all (thread, page_directory);
+  same_page_release_all (thread, page_directory);
+
+  /* Only visit the frames this thread owns, pagedir_destroy () frees them. */
+  lock_acquire (&frame_table_lock);
+  while (!list_empty (&thread->frames)) {
+    Frame *frame = list_entry (list_front (&thread->frames), Frame,
+                               owner_elem);
+    frame_set_owner (frame, NULL, NULL);
+  }
+  lock_release (&frame_table_lock);
 
   pagedir_destroy (page_directory);
 }
@@ -5,15 +5,41 @@
 #include "../lib/kernel/hash.h"
 #include "../threads/thread.h"
 
+struct merged_page;
+struct cache_page;
+
 typedef struct Frame {
     struct thread *owner; /* The (first) owner of this frame. */
     void *user_page;      /* Corresponding user page. */
+    struct spte *spte;    /* Its entry in the owner's page table. */
     bool r;               /* For clock algorithm. */
+    unsigned checksum;    /* Content hash seen by the last merging scan. */
+    struct merged_page *merged; /* Non-NULL if several pages map this frame. */
+    struct cache_page *cached; /* Non-NULL if the frame holds file data. */
+    struct list_elem owner_elem; /* Element in the owner's frames list. */
 } Frame;
 
+struct lock eviction_lock;
+struct lock frame_table_lock;
+
+/* If true, aligned mmap regions may be mapped with 4 MB pages.
+   Controlled by kernel command-line option "-lgpages". */
+extern bool large_user_pages;
+
 void frame_table_init(void *user_pool_base, uint32_t user_pool_page_count);
+uint32_t frame_table_size (void);
+Frame *frame_table_get (uint32_t frame_no);
+void *frame_table_kernel_page (uint32_t frame_no);
+int get_user_frame_number (void *kernel_page);
+void frame_set_owner (Frame *frame, struct thread *owner, struct spte *spte);
+void frame_set_cached (void *kernel_page, struct cache_page *cached);
 
 void *allocate_user_page(void *user_address, bool writable, bool zeroed);
-void free_all_user_pages(struct thread *thread);
+void *obtain_user_frame (bool zeroed);
+bool install_user_frame (void *user_address, void *kernel_page, bool writable);
+void *swap_user_frame (void *user_page, void *kernel_page);
+bool evict_user_frame (void *kernel_page);
+void frame_set_referenced (void *kernel_page, bool referenced);
+void free_all_user_pages(struct thread *thread, uint32_t *page_directory);
 
 #endif /* vm/frame-table.h */
@@ -0,0 +1,747 @@
+#include <string.h>
+#include "page-cache.h"
+#include "frame-table.h"
+#include "same-page.h"
+#include "../filesys/file.h"
+#include "../filesys/inode.h"
+#include "../threads/malloc.h"
+#include "../threads/palloc.h"
+#include "../threads/pte.h"
+#include "../threads/synch.h"
+#include "../threads/vaddr.h"
+#include "../userprog/pagedir.h"
+#include "../userprog/process.h"
+#include "../userprog/uaccess.h"
+
+/* Cached pages, keyed by inode and offset. */
+static struct hash page_cache;
+
+/* Protects page_cache, the cached pages and their mappings, and the
+   value of the spte of every mapping.  Acquired after eviction_lock
+   and before frame_table_lock, never held while touching user memory. */
+static struct lock page_cache_lock;
+
+static struct cache_page *lookup (struct inode *inode, off_t offset);
+static struct cache_page *get_page (struct inode *inode, off_t offset,
+                                    bool *created);
+static bool copy_chunk (uint8_t *page, uint8_t *buffer, off_t size,
+                        bool write);
+static off_t copy_page (struct inode *inode, void *buffer, off_t size,
+                        off_t offset, bool write);
+static struct cache_page *new_page (struct inode *inode, off_t offset,
+                                    void *kernel_page, off_t length);
+static void remove_page (struct cache_page *cp);
+static void drop_page (struct cache_page *cp, bool write);
+static void give_to_cow_mappings (struct cache_page *cp);
+static void remove_cow_mapping (struct cache_page *cp, struct thread *thread,
+                                void *user_page);
+static void unmap_page (struct cache_page *cp, struct cache_mapping *m);
+static void write_back (struct cache_page *cp);
+static struct cache_page *cached_page (void *kernel_page);
+static unsigned cache_page_hash (const struct hash_elem *e, void *aux UNUSED);
+static bool cache_page_less (const struct hash_elem *a,
+                             const struct hash_elem *b, void *aux UNUSED);
+
+/* Initializes the page cache. */
+void
+page_cache_init (void)
+{
+  hash_init (&page_cache, cache_page_hash, cache_page_less, NULL);
+  lock_init (&page_cache_lock);
+}
+
+/* Reads SIZE bytes from INODE into BUFFER, starting at position OFFSET,
+   through the page cache. Returns the number of bytes actually read,
+   which may be less than SIZE if end of file is reached or if no frame
+   could be found. */
+off_t
+page_cache_read (struct inode *inode, void *buffer, off_t size, off_t offset)
+{
+  return copy_page (inode, buffer, size, offset, false);
+}
+
+/* Writes SIZE bytes from BUFFER into INODE, starting at OFFSET,
+   through the page cache. The pages are written to disk when they
+   are evicted, or when INODE is closed for the last time.
+   Returns the number of bytes actually written, which may be less
+   than SIZE if end of file is reached or if no frame could be found. */
+off_t
+page_cache_write (struct inode *inode, const void *buffer, off_t size,
+                  off_t offset)
+{
+  return copy_page (inode, (void *) buffer, size, offset, true);
+}
+
+/* Writes back the cached pages of INODE if WRITE is true, then drops
+   them from the cache. Called when INODE is closed for the last time,
+   at which point none of them is mapped by a file mapping or being
+   copied. */
+void
+page_cache_drop_inode (struct inode *inode, bool write)
+{
+  off_t length = inode_length (inode);
+
+  lock_acquire (&page_cache_lock);
+  for (off_t offset = 0; offset < length; offset += PGSIZE) {
+    struct cache_page *cp = lookup (inode, offset);
+    if (cp != NULL) {
+      ASSERT (cp->pin_cnt == 0);
+      drop_page (cp, write);
+    }
+  }
+  lock_release (&page_cache_lock);
+}
+
+/* Writes every dirty cached page back to disk. */
+void
+page_cache_flush (void)
+{
+  struct hash_iterator it;
+
+  lock_acquire (&page_cache_lock);
+  hash_first (&it, &page_cache);
+  while (hash_next (&it))
+    write_back (hash_entry (hash_cur (&it), struct cache_page, elem));
+  lock_release (&page_cache_lock);
+}
+
+/* Maps the cached page of the file mapping page SPTE into the current
+   thread, reading it from the file first if no other mapping has it.
+   Returns false if no frame could be found for it. */
+bool
+page_cache_map (struct spte *spte)
+{
+  struct thread *cur = process_current ();
+
+  struct cache_mapping *m = malloc (sizeof *m);
+  if (m == NULL)
+    return false;
+  m->thread = cur;
+  m->user_page = spte->vaddr;
+  m->spte = spte;
+
+  struct cache_page *cp;
+  for (;;) {
+    cp = get_page (file_get_inode (spte->file), spte->file_ofs, NULL);
+    if (cp == NULL) {
+      free (m);
+      return false;
+    }
+    if (cp->cow == NULL || !spte->writable)
+      break;
+
+    /* Writes through the mapping must not show in the pages read ()
+       mapped, so give them this frame and cache a fresh one. */
+    drop_page (cp, true);
+    lock_release (&page_cache_lock);
+  }
+
+  if (!pagedir_set_page (cur->pagedir, spte->vaddr, cp->kernel_page,
+                         spte->writable)) {
+    lock_release (&page_cache_lock);
+    free (m);
+    return false;
+  }
+  list_push_back (&cp->mappings, &m->elem);
+  spte->value = cp->kernel_page;
+  spte->bytes_read = cp->length;
+  lock_release (&page_cache_lock);
+  return true;
+}
+
+/* Reads the 4 MB at OFFSET in INODE into an aligned run of frames and
+   maps it at USER_PAGE in the current thread with a single large page,
+   adding every 4 kB page of it to the page cache.  Nothing is evicted
+   for it: returns NULL when no aligned run of frames is free, or when
+   part of the region is already cached, in which case the caller falls
+   back to page_cache_map ().  Otherwise returns the first frame. */
+void *
+page_cache_map_large (struct inode *inode, off_t offset, void *user_page,
+                      bool writable)
+{
+  struct thread *cur = process_current ();
+  struct cache_page **pages = NULL;
+  uint8_t *kernel_page = NULL;
+  off_t length;
+  size_t i;
+
+  if (!large_user_pages)
+    return NULL;
+
+  /* Other threads can find the pages as soon as they are in the
+     cache, so get their mapping records ready before adding them. */
+  pages = calloc (LGPG_PAGES, sizeof *pages);
+  if (pages == NULL)
+    return NULL;
+  for (i = 0; i < LGPG_PAGES; i++) {
+    struct cache_mapping *m = malloc (sizeof *m);
+    pages[i] = malloc (sizeof **pages);
+    if (pages[i] == NULL || m == NULL) {
+      free (pages[i]);
+      free (m);
+      pages[i] = NULL;
+      goto fail;
+    }
+    list_init (&pages[i]->mappings);
+    m->thread = cur;
+    m->user_page = (uint8_t *) user_page + i * PGSIZE;
+    m->spte = spt_find (cur->spt, m->user_page);
+    list_push_back (&pages[i]->mappings, &m->elem);
+  }
+  kernel_page = palloc_get_aligned (PAL_USER, LGPG_PAGES);
+  if (kernel_page == NULL)
+    goto fail;
+
+  length = inode_read_direct (inode, kernel_page, LGPGSIZE, offset);
+  if (length < LGPGSIZE)
+    memset (kernel_page + length, 0, LGPGSIZE - length);
+
+  lock_acquire (&page_cache_lock);
+  for (i = 0; i < LGPG_PAGES; i++) {
+    if (lookup (inode, offset + i * PGSIZE) != NULL) {
+      lock_release (&page_cache_lock);
+      goto fail;
+    }
+  }
+  if (!pagedir_set_large_page (cur->pagedir, user_page, kernel_page,
+                               writable)) {
+    lock_release (&page_cache_lock);
+    goto fail;
+  }
+  for (i = 0; i < LGPG_PAGES; i++) {
+    struct cache_page *cp = pages[i];
+    off_t page_start = i * PGSIZE;
+    cp->inode = inode;
+    cp->offset = offset + page_start;
+    cp->kernel_page = kernel_page + page_start;
+    if (length <= page_start)
+      cp->length = 0;
+    else if (length - page_start < PGSIZE)
+      cp->length = length - page_start;
+    else
+      cp->length = PGSIZE;
+    cp->dirty = false;
+    cp->pin_cnt = 0;
+    cp->cow = NULL;
+    hash_insert (&page_cache, &cp->elem);
+    frame_set_cached (cp->kernel_page, cp);
+  }
+  lock_release (&page_cache_lock);
+  free (pages);
+  return kernel_page;
+
+ fail:
+  if (kernel_page != NULL)
+    palloc_free_multiple (kernel_page, LGPG_PAGES);
+  for (i = 0; i < LGPG_PAGES && pages[i] != NULL; i++) {
+    struct list *mappings = &pages[i]->mappings;
+    while (!list_empty (mappings))
+      free (list_entry (list_pop_front (mappings),
+                        struct cache_mapping, elem));
+    free (pages[i]);
+  }
+  free (pages);
+  return NULL;
+}
+
+/* Unmaps the file mapping page SPTE from the current thread.  The
+   page stays in the cache until it is evicted. */
+void
+page_cache_unmap (struct spte *spte)
+{
+  struct thread *cur = process_current ();
+
+  lock_acquire (&page_cache_lock);
+  if (spte->value != NULL) {
+    struct cache_page *cp = cached_page (spte->value);
+    struct list_elem *e;
+    for (e = list_begin (&cp->mappings); e != list_end (&cp->mappings);
+         e = list_next (e)) {
+      struct cache_mapping *m = list_entry (e, struct cache_mapping, elem);
+      if (m->thread == cur && m->user_page == spte->vaddr) {
+        unmap_page (cp, m);
+        break;
+      }
+    }
+  }
+  lock_release (&page_cache_lock);
+}
+
+/* Writes the cached page in KERNEL_PAGE back to its file if it was
+   written through any of its mappings or otherwise since it was last
+   written back.  Collects the dirty bits of the mappings into the
+   page first, so that a later write through them is seen again.
+   The page cannot be evicted while it is written. */
+void
+page_cache_write_back (void *kernel_page)
+{
+  lock_acquire (&page_cache_lock);
+  struct cache_page *cp = cached_page (kernel_page);
+  if (cp != NULL) {
+    struct list_elem *e;
+    for (e = list_begin (&cp->mappings); e != list_end (&cp->mappings);
+         e = list_next (e)) {
+      struct cache_mapping *m = list_entry (e, struct cache_mapping, elem);
+      uint32_t *pd = m->thread->pagedir;
+      if (pagedir_is_dirty (pd, m->user_page)) {
+        cp->dirty = true;
+        /* A large page has one dirty bit for all of its pages. */
+        if (!pagedir_is_large (pd, m->user_page))
+          pagedir_set_dirty (pd, m->user_page, false);
+      }
+    }
+    write_back (cp);
+  }
+  lock_release (&page_cache_lock);
+}
+
+/* Evicts the cached page in KERNEL_PAGE: unmaps it from every thread
+   mapping it, writes it back if it is dirty and frees its frame.
+   Does nothing if the page is being copied by read () or write ().
+   Must hold eviction_lock. */
+void
+page_cache_evict (void *kernel_page)
+{
+  lock_acquire (&page_cache_lock);
+  struct cache_page *cp = cached_page (kernel_page);
+  if (cp != NULL && cp->pin_cnt == 0)
+    drop_page (cp, true);
+  lock_release (&page_cache_lock);
+}
+
+/* Maps the cached page at OFFSET in INODE read-only at USER_PAGE in the
+   current thread, in place of the anonymous page there, as if it had
+   been copied there.  The first write to USER_PAGE gives it a private
+   copy.  Returns false, changing nothing, if the page is not a whole
+   page of file data, if it is mapped by a file mapping, or if
+   USER_PAGE is not a writable anonymous page that is present right
+   now; the caller should copy the data instead. */
+bool
+page_cache_map_cow (struct inode *inode, off_t offset, void *user_page)
+{
+  struct thread *cur = process_current ();
+  struct spte *spte = spt_find (cur->spt, user_page);
+
+  if (spte == NULL || spte->status == MMAP || !spte->writable
+      || spte->is_shared)
+    return false;
+
+  /* The old frame of USER_PAGE is freed below and its data is lost,
+     so get the copy-on-write records before touching it. */
+  struct merged_mapping *m = malloc (sizeof *m);
+  struct merged_page *mp = malloc (sizeof *mp);
+  if (m == NULL || mp == NULL) {
+    free (m);
+    free (mp);
+    return false;
+  }
+  m->thread = cur;
+  m->user_page = user_page;
+  m->spte = spte;
+
+  struct cache_page *cp = get_page (inode, offset, NULL);
+  if (cp == NULL) {
+    free (m);
+    free (mp);
+    return false;
+  }
+
+  /* The user page must not be evicted while it is replaced, and the
+     eviction lock comes first, so pin CP while taking the locks in
+     order. */
+  cp->pin_cnt++;
+  lock_release (&page_cache_lock);
+  lock_acquire (&eviction_lock);
+  lock_acquire (&page_cache_lock);
+  cp->pin_cnt--;
+
+  void *old_page = pagedir_get_page (cur->pagedir, user_page);
+  bool ok = cp->length == PGSIZE && list_empty (&cp->mappings)
+            && old_page != NULL && !spte->is_shared;
+  if (ok && spte->cow == cp) {
+    /* Read again into the same place, nothing to do. */
+    free (m);
+    free (mp);
+  } else if (ok) {
+    pagedir_clear_page (cur->pagedir, user_page);
+    if (spte->cow != NULL)
+      remove_cow_mapping (spte->cow, cur, user_page);
+    else {
+      lock_acquire (&frame_table_lock);
+      frame_set_owner (frame_table_get (get_user_frame_number (old_page)),
+                       NULL, NULL);
+      lock_release (&frame_table_lock);
+      palloc_free_page (old_page);
+    }
+    /* The page table of USER_PAGE exists, so this cannot fail. */
+    pagedir_set_page (cur->pagedir, user_page, cp->kernel_page, false);
+
+    if (cp->cow == NULL) {
+      mp->kernel_page = cp->kernel_page;
+      list_init (&mp->mappings);
+      cp->cow = mp;
+    } else
+      free (mp);
+    list_push_back (&cp->cow->mappings, &m->elem);
+    spte->status = FRAME;
+    spte->value = cp->kernel_page;
+    spte->cow = cp;
+  } else {
+    free (m);
+    free (mp);
+  }
+  lock_release (&page_cache_lock);
+  lock_release (&eviction_lock);
+  return ok;
+}
+
+/* Gives the current thread a private, writable copy of the cached
+   page that SPTE maps copy-on-write after a write fault on it.
+   Returns false if the page may not be written at all. */
+bool
+page_cache_break_cow (struct spte *spte)
+{
+  struct thread *cur = process_current ();
+
+  if (!spte->writable)
+    return false;
+
+  void *kernel_page = obtain_user_frame (false);
+  if (kernel_page == NULL)
+    return false;
+
+  lock_acquire (&page_cache_lock);
+  struct cache_page *cp = spte->cow;
+  if (cp == NULL) {
+    /* The page left the cache while we were getting a frame, and its
+       frame was handed over to us, alone or merged. */
+    lock_release (&page_cache_lock);
+    palloc_free_page (kernel_page);
+    if (spte->is_shared)
+      return same_page_break (spte);
+    return pagedir_is_writable (cur->pagedir, spte->vaddr);
+  }
+  memcpy (kernel_page, cp->kernel_page, PGSIZE);
+  pagedir_clear_page (cur->pagedir, spte->vaddr);
+  remove_cow_mapping (cp, cur, spte->vaddr);
+  spte->cow = NULL;
+  lock_release (&page_cache_lock);
+
+  if (!install_user_frame (spte->vaddr, kernel_page, true)) {
+    palloc_free_page (kernel_page);
+    return false;
+  }
+  spte->value = kernel_page;
+  return true;
+}
+
+/* Unmaps every cached page THREAD maps copy-on-write from PD, so that
+   destroying PD does not free frames of the cache. */
+void
+page_cache_release_all (struct thread *thread, uint32_t *pd)
+{
+  if (thread->spt == NULL || pd == NULL)
+    return;
+
+  lock_acquire (&page_cache_lock);
+  struct hash_iterator it;
+  hash_first (&it, thread->spt);
+  while (hash_next (&it)) {
+    struct spte *spte = hash_entry (hash_cur (&it), struct spte, elem);
+    if (spte->cow != NULL) {
+      pagedir_clear_page (pd, spte->vaddr);
+      remove_cow_mapping (spte->cow, thread, spte->vaddr);
+      spte->cow = NULL;
+    }
+  }
+  lock_release (&page_cache_lock);
+}
+
+/* Returns the cached page at OFFSET in INODE, or NULL if it is not
+   cached.  Must hold page_cache_lock. */
+static struct cache_page *
+lookup (struct inode *inode, off_t offset)
+{
+  struct cache_page key;
+  key.inode = inode;
+  key.offset = offset;
+  struct hash_elem *e = hash_find (&page_cache, &key.elem);
+  return e != NULL ? hash_entry (e, struct cache_page, elem) : NULL;
+}
+
+/* Copies SIZE bytes at OFFSET in INODE to BUFFER, or from BUFFER if
+   WRITE is true, through the page cache.  BUFFER may be in user memory,
+   in which case the copy stops at the first page of it that cannot be
+   accessed.  Returns the number of bytes copied. */
+static off_t
+copy_page (struct inode *inode, void *buffer_, off_t size, off_t offset,
+           bool write)
+{
+  uint8_t *buffer = buffer_;
+  off_t length = inode_length (inode);
+  off_t bytes_copied = 0;
+
+  while (size > 0 && offset < length) {
+    /* Bytes left in file, bytes left in page, lesser of the two. */
+    off_t page_ofs = offset % PGSIZE;
+    off_t chunk_size = PGSIZE - page_ofs;
+    if (chunk_size > length - offset)
+      chunk_size = length - offset;
+    if (chunk_size > size)
+      chunk_size = size;
+
+    bool created;
+    struct cache_page *cp = get_page (inode, offset - page_ofs, &created);
+    if (cp == NULL)
+      break;
+    if (write && cp->cow != NULL) {
+      /* Keep the data read () mapped intact, see page_cache_map (). */
+      drop_page (cp, true);
+      lock_release (&page_cache_lock);
+      continue;
+    }
+
+    /* A page brought in by read () or write () is reclaimed first
+       unless it is used again, so that streaming through a file does
+       not push anonymous memory out. */
+    frame_set_referenced (cp->kernel_page, !created);
+
+    /* Copying may fault on BUFFER, and handling the fault may need the
+       lock, so pin the page instead of holding the lock. */
+    cp->pin_cnt++;
+    lock_release (&page_cache_lock);
+    bool copied = copy_chunk ((uint8_t *) cp->kernel_page + page_ofs,
+                              buffer + bytes_copied, chunk_size, write);
+    lock_acquire (&page_cache_lock);
+    cp->pin_cnt--;
+    if (write)
+      cp->dirty = true;
+    lock_release (&page_cache_lock);
+    if (!copied)
+      break;
+
+    /* Advance. */
+    size -= chunk_size;
+    offset += chunk_size;
+    bytes_copied += chunk_size;
+  }
+  return bytes_copied;
+}
+
+/* Copies SIZE bytes from BUFFER to the cached data at PAGE if WRITE
+   is true, or from PAGE to BUFFER otherwise.  A user BUFFER is accessed
+   with copy_from_user () or copy_to_user (), so that a bad address
+   fails the copy instead of killing the kernel.  Returns false if the
+   copy failed. */
+static bool
+copy_chunk (uint8_t *page, uint8_t *buffer, off_t size, bool write)
+{
+  if (is_user_vaddr (buffer)) {
+    if (write)
+      return copy_from_user (page, buffer, size);
+    return copy_to_user (buffer, page, size);
+  }
+  if (write)
+    memcpy (page, buffer, size);
+  else
+    memcpy (buffer, page, size);
+  return true;
+}
+
+/* Returns the cached page at OFFSET in INODE, reading it from disk if
+   it is not cached yet.  If CREATED is non-null, *CREATED tells which
+   one happened.  Returns with page_cache_lock held, or NULL without it
+   if no frame could be found. */
+static struct cache_page *
+get_page (struct inode *inode, off_t offset, bool *created)
+{
+  if (created != NULL)
+    *created = false;
+
+  lock_acquire (&page_cache_lock);
+  struct cache_page *cp = lookup (inode, offset);
+  if (cp != NULL)
+    return cp;
+  lock_release (&page_cache_lock);
+
+  /* Getting a frame may evict a cached page, so do it and the read
+     without the lock, then check that no one cached the page since. */
+  uint8_t *kernel_page = obtain_user_frame (false);
+  if (kernel_page == NULL)
+    return NULL;
+  off_t length = inode_read_direct (inode, kernel_page, PGSIZE, offset);
+  memset (kernel_page + length, 0, PGSIZE - length);
+
+  lock_acquire (&page_cache_lock);
+  cp = lookup (inode, offset);
+  if (cp != NULL) {
+    palloc_free_page (kernel_page);
+    return cp;
+  }
+  cp = new_page (inode, offset, kernel_page, length);
+  if (cp == NULL) {
+    lock_release (&page_cache_lock);
+    palloc_free_page (kernel_page);
+  } else if (created != NULL)
+    *created = true;
+  return cp;
+}
+
+/* Adds the LENGTH bytes at OFFSET in INODE held in KERNEL_PAGE to the
+   cache.  Returns NULL if memory is short.  Must hold page_cache_lock. */
+static struct cache_page *
+new_page (struct inode *inode, off_t offset, void *kernel_page,
+          off_t length)
+{
+  struct cache_page *cp = malloc (sizeof *cp);
+  if (cp == NULL)
+    return NULL;
+  cp->inode = inode;
+  cp->offset = offset;
+  cp->length = length;
+  cp->kernel_page = kernel_page;
+  cp->dirty = false;
+  cp->pin_cnt = 0;
+  list_init (&cp->mappings);
+  cp->cow = NULL;
+  hash_insert (&page_cache, &cp->elem);
+  frame_set_cached (kernel_page, cp);
+  return cp;
+}
+
+/* Drops CP, which must not be mapped any more, from the cache and
+   frees its frame.  Must hold page_cache_lock. */
+static void
+remove_page (struct cache_page *cp)
+{
+  ASSERT (list_empty (&cp->mappings));
+
+  hash_delete (&page_cache, &cp->elem);
+  frame_set_cached (cp->kernel_page, NULL);
+  palloc_free_page (cp->kernel_page);
+  free (cp);
+}
+
+/* Takes CP out of the cache: unmaps it from the file mappings, writes
+   it back if it is dirty and WRITE is true, and frees its frame, or
+   hands the frame over to the pages that map CP copy-on-write, which
+   must keep seeing the data they read.  Must hold page_cache_lock. */
+static void
+drop_page (struct cache_page *cp, bool write)
+{
+  while (!list_empty (&cp->mappings))
+    unmap_page (cp, list_entry (list_front (&cp->mappings),
+                                struct cache_mapping, elem));
+  if (write)
+    write_back (cp);
+  if (cp->cow != NULL)
+    give_to_cow_mappings (cp);
+  else
+    remove_page (cp);
+}
+
+/* Drops CP from the cache and turns its frame into an anonymous frame
+   of the pages that map it copy-on-write: a private frame if there is
+   only one, otherwise a merged page of them, see same_page_break ().
+   Must hold page_cache_lock. */
+static void
+give_to_cow_mappings (struct cache_page *cp)
+{
+  struct merged_page *mp = cp->cow;
+  struct list_elem *e;
+
+  hash_delete (&page_cache, &cp->elem);
+  frame_set_cached (cp->kernel_page, NULL);
+
+  lock_acquire (&frame_table_lock);
+  if (!same_page_set_owner (mp)) {
+    for (e = list_begin (&mp->mappings); e != list_end (&mp->mappings);
+         e = list_next (e)) {
+      struct merged_mapping *m = list_entry (e, struct merged_mapping, elem);
+      struct spte *spte = m->spte;
+      spte->cow = NULL;
+      spte->is_shared = true;
+      spte->merged = mp;
+    }
+    frame_table_get (get_user_frame_number (cp->kernel_page))->merged = mp;
+  }
+  lock_release (&frame_table_lock);
+  free (cp);
+}
+
+/* Removes the copy-on-write mapping of CP at USER_PAGE in THREAD.
+   Must hold page_cache_lock. */
+static void
+remove_cow_mapping (struct cache_page *cp, struct thread *thread,
+                    void *user_page)
+{
+  struct list_elem *e;
+  for (e = list_begin (&cp->cow->mappings); e != list_end (&cp->cow->mappings);
+       e = list_next (e)) {
+    struct merged_mapping *m = list_entry (e, struct merged_mapping, elem);
+    if (m->thread == thread && m->user_page == user_page) {
+      list_remove (e);
+      free (m);
+      break;
+    }
+  }
+  if (list_empty (&cp->cow->mappings)) {
+    free (cp->cow);
+    cp->cow = NULL;
+  }
+}
+
+/* Removes mapping M of CP, keeping its dirty bit in CP.
+   Must hold page_cache_lock. */
+static void
+unmap_page (struct cache_page *cp, struct cache_mapping *m)
+{
+  uint32_t *pd = m->thread->pagedir;
+
+  if (pagedir_is_dirty (pd, m->user_page))
+    cp->dirty = true;
+  pagedir_clear_page (pd, m->user_page);
+  m->spte->value = NULL;
+  list_remove (&m->elem);
+  free (m);
+}
+
+/* Writes CP back to its file if it is dirty.  The page is marked
+   clean first, so that a write into it while it is being written
+   out leaves it dirty.  Must hold page_cache_lock. */
+static void
+write_back (struct cache_page *cp)
+{
+  if (cp->dirty) {
+    cp->dirty = false;
+    inode_write_direct (cp->inode, cp->kernel_page, cp->length, cp->offset);
+  }
+}
+
+/* Returns the cached page held in KERNEL_PAGE, or NULL if the frame
+   does not belong to the cache.  Must hold page_cache_lock. */
+static struct cache_page *
+cached_page (void *kernel_page)
+{
+  return frame_table_get (get_user_frame_number (kernel_page))->cached;
+}
+
+/* Hash function of cached pages, based on their inode and offset. */
+static unsigned
+cache_page_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  const struct cache_page *cp = hash_entry (e, struct cache_page, elem);
+  return hash_bytes (&cp->inode, sizeof cp->inode) ^ hash_int (cp->offset);
+}
+
+/* Hash less function of cached pages. */
+static bool
+cache_page_less (const struct hash_elem *a_, const struct hash_elem *b_,
+                 void *aux UNUSED)
+{
+  const struct cache_page *a = hash_entry (a_, struct cache_page, elem);
+  const struct cache_page *b = hash_entry (b_, struct cache_page, elem);
+  if (a->inode != b->inode)
+    return a->inode < b->inode;
+  return a->offset < b->offset;
+}
@@ -0,0 +1,57 @@
+#ifndef VM_PAGE_CACHE_H
+#define VM_PAGE_CACHE_H
+
+#include <stdbool.h>
+#include "lib/kernel/hash.h"
+#include "lib/kernel/list.h"
+#include "filesys/off_t.h"
+#include "threads/thread.h"
+#include "vm/spt.h"
+
+struct inode;
+
+/* A page of file data held in a frame of the user pool. read () and
+   write () copy from and to it, and every file mapping of the page
+   maps that same frame, so they all see each other's writes
+   immediately.  A page aligned read () of the whole page maps the
+   frame read-only into the buffer instead of copying it; those
+   copy-on-write mappings get the frame, as a merged page, when the
+   page leaves the cache or is about to change. */
+struct cache_page {
+  struct inode *inode;                /* File the page belongs to. */
+  off_t offset;                       /* Page aligned offset in INODE. */
+  off_t length;                       /* Bytes of file data in the page. */
+  void *kernel_page;                  /* Frame holding the data. */
+  bool dirty;                         /* Newer than the data on disk. */
+  int pin_cnt;                        /* Being copied, do not evict. */
+  struct list mappings;               /* List of struct cache_mapping. */
+  struct merged_page *cow;            /* Copy-on-write mappings, or NULL. */
+  struct hash_elem elem;              /* Element in the page cache. */
+};
+
+/* One user page mapping a cached page. */
+struct cache_mapping {
+  struct thread *thread;              /* Thread mapping the page. */
+  void *user_page;                    /* Where it is mapped. */
+  struct spte *spte;                  /* Its entry in THREAD's page table. */
+  struct list_elem elem;              /* List elem. */
+};
+
+void page_cache_init (void);
+off_t page_cache_read (struct inode *inode, void *buffer, off_t size,
+                       off_t offset);
+off_t page_cache_write (struct inode *inode, const void *buffer, off_t size,
+                        off_t offset);
+void page_cache_drop_inode (struct inode *inode, bool write);
+void page_cache_flush (void);
+bool page_cache_map (struct spte *spte);
+void *page_cache_map_large (struct inode *inode, off_t offset,
+                            void *user_page, bool writable);
+void page_cache_unmap (struct spte *spte);
+void page_cache_write_back (void *kernel_page);
+void page_cache_evict (void *kernel_page);
+bool page_cache_map_cow (struct inode *inode, off_t offset, void *user_page);
+bool page_cache_break_cow (struct spte *spte);
+void page_cache_release_all (struct thread *thread, uint32_t *pd);
+
+#endif /* vm/page-cache.h */
@@ -0,0 +1,346 @@
+#include <stdio.h>
+#include <string.h>
+#include "same-page.h"
+#include "frame-table.h"
+#include "../devices/timer.h"
+#include "../lib/kernel/hash.h"
+#include "../threads/interrupt.h"
+#include "../threads/malloc.h"
+#include "../threads/palloc.h"
+#include "../threads/vaddr.h"
+#include "../userprog/pagedir.h"
+#include "../userprog/process.h"
+
+/* Timer ticks between two scans of the frame table. */
+#define SCAN_INTERVAL 100
+
+/* A frame whose contents did not change between two scans,
+   indexed by the hash of its contents. */
+struct stable_frame {
+  unsigned checksum;                  /* Hash of the frame contents. */
+  uint32_t frame_no;                  /* Frame holding those contents. */
+  struct hash_elem elem;              /* Hash elem. */
+};
+
+bool same_page_enabled;
+
+/* Statistics. */
+static long long pages_scanned;       /* # of frames hashed by the scanner. */
+static long long pages_merged;        /* # of frames freed by merging. */
+static long long pages_broken;        /* # of copy-on-write breaks. */
+
+static void scanner (void *aux UNUSED);
+static void scan_frames (void);
+static bool merge_frames (uint32_t target_no, uint32_t victim_no);
+static void remove_mapping (struct merged_page *mp, struct thread *thread,
+                            void *user_page);
+static unsigned stable_frame_hash (const struct hash_elem *e, void *aux UNUSED);
+static bool stable_frame_less (const struct hash_elem *a,
+                               const struct hash_elem *b, void *aux UNUSED);
+static void stable_frame_free (struct hash_elem *e, void *aux UNUSED);
+
+/* Starts the merging scanner if it was enabled on the command line. */
+void
+same_page_init (void)
+{
+  if (same_page_enabled)
+    thread_create ("same-page", PRI_MIN, scanner, NULL);
+}
+
+/* Prints merging statistics. */
+void
+same_page_print_stats (void)
+{
+  printf ("Same-page: %lld pages scanned, %lld merged, %lld broken\n",
+          pages_scanned, pages_merged, pages_broken);
+}
+
+/* Gives the current thread a private, writable copy of the merged
+   page described by SPTE after a write fault on it.
+   Returns false if the page may not be written at all. */
+bool
+same_page_break (struct spte *spte)
+{
+  struct thread *cur = process_current ();
+
+  if (!spte->writable)
+    return false;
+
+  if (spte->merged == NULL) {
+    /* The other mappings went away and the frame was handed back to us
+       writable, but the stale read-only TLB entry faulted first. */
+    return pagedir_is_writable (cur->pagedir, spte->vaddr);
+  }
+
+  void *kernel_page = obtain_user_frame (false);
+  if (kernel_page == NULL)
+    return false;
+
+  lock_acquire (&frame_table_lock);
+  struct merged_page *mp = spte->merged;
+  if (mp == NULL) {
+    /* Same as above, but it happened while we were getting a frame. */
+    lock_release (&frame_table_lock);
+    palloc_free_page (kernel_page);
+    return true;
+  }
+  memcpy (kernel_page, mp->kernel_page, PGSIZE);
+  pagedir_clear_page (cur->pagedir, spte->vaddr);
+  spte->is_shared = false;
+  spte->merged = NULL;
+  remove_mapping (mp, cur, spte->vaddr);
+  pages_broken++;
+  lock_release (&frame_table_lock);
+
+  if (!install_user_frame (spte->vaddr, kernel_page, true)) {
+    palloc_free_page (kernel_page);
+    return false;
+  }
+  spte->value = kernel_page;
+  return true;
+}
+
+/* Unmaps every merged page of THREAD from PD, so that destroying PD
+   does not free frames other processes still use. */
+void
+same_page_release_all (struct thread *thread, uint32_t *pd)
+{
+  if (thread->spt == NULL || pd == NULL)
+    return;
+
+  lock_acquire (&frame_table_lock);
+  struct hash_iterator it;
+  hash_first (&it, thread->spt);
+  while (hash_next (&it)) {
+    struct spte *spte = hash_entry (hash_cur (&it), struct spte, elem);
+    struct merged_page *mp = spte->merged;
+    if (mp != NULL) {
+      pagedir_clear_page (pd, spte->vaddr);
+      spte->is_shared = false;
+      spte->merged = NULL;
+      remove_mapping (mp, thread, spte->vaddr);
+    }
+  }
+  lock_release (&frame_table_lock);
+}
+
+/* Kernel thread that periodically merges identical frames. */
+static void
+scanner (void *aux UNUSED)
+{
+  for (;;) {
+    timer_sleep (SCAN_INTERVAL);
+    scan_frames ();
+  }
+}
+
+/* Returns the spte of the anonymous page held in FRAME, or NULL if
+   FRAME does not hold one. Must hold frame_table_lock. */
+static struct spte *
+anonymous_spte (Frame *frame)
+{
+  if (frame->owner == NULL || frame->owner->pagedir == NULL
+      || frame->spte == NULL || frame->spte->status == MMAP)
+    return NULL;
+  return frame->spte;
+}
+
+/* Hashes every anonymous frame and merges the ones whose contents
+   were stable since the last scan and equal to another stable frame. */
+static void
+scan_frames (void)
+{
+  struct hash stable;
+  if (!hash_init (&stable, stable_frame_hash, stable_frame_less, NULL))
+    return;
+
+  /* Holding the eviction lock keeps frames from being freed under us. */
+  lock_acquire (&eviction_lock);
+  lock_acquire (&frame_table_lock);
+  for (uint32_t i = 0; i < frame_table_size (); i++) {
+    Frame *frame = frame_table_get (i);
+    if (anonymous_spte (frame) == NULL)
+      continue;
+
+    pages_scanned++;
+    unsigned checksum = hash_bytes (frame_table_kernel_page (i), PGSIZE);
+    bool unchanged = frame->checksum == checksum;
+    frame->checksum = checksum;
+    if (!unchanged)
+      continue;
+
+    struct stable_frame key;
+    key.checksum = checksum;
+    struct hash_elem *e = hash_find (&stable, &key.elem);
+    if (e == NULL) {
+      struct stable_frame *sf = malloc (sizeof (struct stable_frame));
+      if (sf != NULL) {
+        sf->checksum = checksum;
+        sf->frame_no = i;
+        hash_insert (&stable, &sf->elem);
+      }
+    } else if (frame->merged == NULL) {
+      struct stable_frame *sf = hash_entry (e, struct stable_frame, elem);
+      if (merge_frames (sf->frame_no, i))
+        pages_merged++;
+    }
+  }
+  lock_release (&frame_table_lock);
+  lock_release (&eviction_lock);
+
+  hash_destroy (&stable, stable_frame_free);
+}
+
+/* Remaps the page held in frame VICTIM_NO onto frame TARGET_NO if both
+   have the same contents, then frees VICTIM_NO. Both pages become
+   read-only. Must hold frame_table_lock. */
+static bool
+merge_frames (uint32_t target_no, uint32_t victim_no)
+{
+  Frame *target = frame_table_get (target_no);
+  Frame *victim = frame_table_get (victim_no);
+  void *target_page = frame_table_kernel_page (target_no);
+  void *victim_page = frame_table_kernel_page (victim_no);
+  struct spte *target_spte = anonymous_spte (target);
+  struct spte *victim_spte = anonymous_spte (victim);
+
+  if (target_spte == NULL || victim_spte == NULL)
+    return false;
+
+  /* Allocate everything up front, so that nothing can fail once the
+     page tables have been changed. */
+  struct merged_page *mp = target->merged;
+  struct merged_mapping *target_mapping = NULL;
+  struct merged_mapping *victim_mapping = malloc (sizeof *victim_mapping);
+  if (victim_mapping == NULL)
+    return false;
+  if (mp == NULL) {
+    mp = malloc (sizeof *mp);
+    target_mapping = malloc (sizeof *target_mapping);
+    if (mp == NULL || target_mapping == NULL) {
+      free (mp);
+      free (target_mapping);
+      free (victim_mapping);
+      return false;
+    }
+  }
+
+  /* The owners could write to either page between the comparison and
+     the remapping, so do both atomically. */
+  enum intr_level old_level = intr_disable ();
+  if (memcmp (target_page, victim_page, PGSIZE) != 0) {
+    intr_set_level (old_level);
+    if (target_mapping != NULL) {
+      free (mp);
+      free (target_mapping);
+    }
+    free (victim_mapping);
+    return false;
+  }
+  pagedir_clear_page (victim->owner->pagedir, victim->user_page);
+  pagedir_set_page (victim->owner->pagedir, victim->user_page,
+                    target_page, false);
+  if (target_mapping != NULL)
+    pagedir_set_writable (target->owner->pagedir, target->user_page, false);
+  intr_set_level (old_level);
+
+  if (target_mapping != NULL) {
+    mp->kernel_page = target_page;
+    list_init (&mp->mappings);
+    target_mapping->thread = target->owner;
+    target_mapping->user_page = target->user_page;
+    target_mapping->spte = target_spte;
+    list_push_back (&mp->mappings, &target_mapping->elem);
+    target_spte->is_shared = true;
+    target_spte->merged = mp;
+    target_spte->value = target_page;
+    target->merged = mp;
+  }
+
+  victim_mapping->thread = victim->owner;
+  victim_mapping->user_page = victim->user_page;
+  victim_mapping->spte = victim_spte;
+  list_push_back (&mp->mappings, &victim_mapping->elem);
+  victim_spte->is_shared = true;
+  victim_spte->merged = mp;
+  victim_spte->value = target_page;
+
+  frame_set_owner (victim, NULL, NULL);
+  victim->checksum = 0;
+  palloc_free_page (victim_page);
+  return true;
+}
+
+/* Removes the mapping of USER_PAGE in THREAD from MP. When a single
+   mapping is left, the frame goes back to being a private frame of
+   that page. Must hold frame_table_lock. */
+static void
+remove_mapping (struct merged_page *mp, struct thread *thread,
+                void *user_page)
+{
+  struct list_elem *e;
+  for (e = list_begin (&mp->mappings); e != list_end (&mp->mappings);
+       e = list_next (e)) {
+    struct merged_mapping *m = list_entry (e, struct merged_mapping, elem);
+    if (m->thread == thread && m->user_page == user_page) {
+      list_remove (e);
+      free (m);
+      break;
+    }
+  }
+
+  same_page_set_owner (mp);
+}
+
+/* Records the first page mapping MP as the owner of its frame, since
+   the frame table records a single owner.  If it is the only page
+   left, the frame goes back to being a private frame of that page,
+   writable again if the page is, and MP is freed.  Returns true in
+   that case.  Also used for the copy-on-write mappings of a cached
+   page, see page-cache.c.  Must hold frame_table_lock. */
+bool
+same_page_set_owner (struct merged_page *mp)
+{
+  Frame *frame = frame_table_get (get_user_frame_number (mp->kernel_page));
+  struct merged_mapping *first = list_entry (list_front (&mp->mappings),
+                                             struct merged_mapping, elem);
+  frame_set_owner (frame, first->thread, first->spte);
+
+  if (list_size (&mp->mappings) > 1)
+    return false;
+
+  struct spte *spte = first->spte;
+  if (first->thread->pagedir != NULL)
+    pagedir_set_writable (first->thread->pagedir, first->user_page,
+                          spte->writable);
+  spte->is_shared = false;
+  spte->merged = NULL;
+  spte->cow = NULL;
+  frame->merged = NULL;
+  free (first);
+  free (mp);
+  return true;
+}
+
+/* Hash function of stable frames, based on their checksum. */
+static unsigned
+stable_frame_hash (const struct hash_elem *e, void *aux UNUSED)
+{
+  return hash_entry (e, struct stable_frame, elem)->checksum;
+}
+
+/* Hash less function of stable frames. */
+static bool
+stable_frame_less (const struct hash_elem *a, const struct hash_elem *b,
+                   void *aux UNUSED)
+{
+  return hash_entry (a, struct stable_frame, elem)->checksum
+         < hash_entry (b, struct stable_frame, elem)->checksum;
+}
+
+/* Frees a stable frame record. */
+static void
+stable_frame_free (struct hash_elem *e, void *aux UNUSED)
+{
+  free (hash_entry (e, struct stable_frame, elem));
+}
@@ -0,0 +1,36 @@
+#ifndef VM_SAME_PAGE_H
+#define VM_SAME_PAGE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "lib/kernel/list.h"
+#include "threads/thread.h"
+#include "vm/spt.h"
+
+/* A frame whose identical contents were found in several anonymous
+   pages. Every page in MAPPINGS maps KERNEL_PAGE read-only until it
+   is written, at which point it gets a private copy. */
+struct merged_page {
+  void *kernel_page;                  /* The shared frame. */
+  struct list mappings;               /* List of struct merged_mapping. */
+};
+
+/* One user page mapping a merged frame. */
+struct merged_mapping {
+  struct thread *thread;              /* Thread mapping the frame. */
+  void *user_page;                    /* Where it is mapped. */
+  struct spte *spte;                  /* Its entry in THREAD's page table. */
+  struct list_elem elem;              /* List elem. */
+};
+
+/* If true, the merging scanner is started at boot.
+   Controlled by kernel command-line option "-merge". */
+extern bool same_page_enabled;
+
+void same_page_init (void);
+bool same_page_break (struct spte *spte);
+void same_page_release_all (struct thread *thread, uint32_t *pd);
+bool same_page_set_owner (struct merged_page *mp);
+void same_page_print_stats (void);
+
+#endif /* vm/same-page.h */
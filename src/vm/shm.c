@@ -0,0 +1,95 @@
+#include <string.h>
+#include "shm.h"
+#include "../filesys/filesys.h"
+#include "../filesys/inode.h"
+#include "../lib/kernel/list.h"
+#include "../threads/malloc.h"
+#include "../threads/synch.h"
+
+/* A named shared memory segment.  Its data lives in a file that no
+   directory refers to, so every process mapping it maps the same
+   frames of the page cache, see page_cache_map (), and those frames
+   are evicted like any other cached page, to the sectors of that file
+   instead of the swap disk. */
+struct shm_segment {
+  char name[SHM_NAME_MAX + 1];        /* Name passed to shm_open (). */
+  struct inode *inode;                /* Anonymous file holding the data. */
+  struct list_elem elem;              /* Element in segments. */
+};
+
+/* Every segment that has not been unlinked. */
+static struct list segments;
+
+/* Protects segments. */
+static struct lock shm_lock;
+
+static struct shm_segment *lookup (const char *name);
+
+/* Initializes the segment table. */
+void
+shm_init (void)
+{
+  list_init (&segments);
+  lock_init (&shm_lock);
+}
+
+/* Returns a new reference to the inode of segment NAME, creating the
+   segment with SIZE zeroed bytes if there is none.  SIZE is ignored
+   if the segment exists.  Returns NULL if NAME is too long, or if the
+   segment does not exist and cannot be created, for instance because
+   SIZE is 0.  Must hold filesys_lock. */
+struct inode *
+shm_open_inode (const char *name, off_t size)
+{
+  if (strlen (name) > SHM_NAME_MAX)
+    return NULL;
+
+  lock_acquire (&shm_lock);
+  struct shm_segment *seg = lookup (name);
+  if (seg == NULL && size > 0 && (seg = malloc (sizeof *seg)) != NULL) {
+    seg->inode = filesys_create_anonymous (size);
+    if (seg->inode != NULL) {
+      strlcpy (seg->name, name, sizeof seg->name);
+      list_push_back (&segments, &seg->elem);
+    } else {
+      free (seg);
+      seg = NULL;
+    }
+  }
+  struct inode *inode = seg != NULL ? inode_reopen (seg->inode) : NULL;
+  lock_release (&shm_lock);
+  return inode;
+}
+
+/* Removes segment NAME, so that shm_open_inode () creates a new one.
+   Processes that have it open or mapped keep it until they let go.
+   Returns false if there is no such segment.  Must hold filesys_lock. */
+bool
+shm_unlink_segment (const char *name)
+{
+  lock_acquire (&shm_lock);
+  struct shm_segment *seg = lookup (name);
+  if (seg != NULL) {
+    list_remove (&seg->elem);
+    inode_close (seg->inode);
+    free (seg);
+  }
+  lock_release (&shm_lock);
+  return seg != NULL;
+}
+
+/* Returns segment NAME, or NULL if there is none.
+   Must hold shm_lock. */
+static struct shm_segment *
+lookup (const char *name)
+{
+  struct list_elem *e;
+
+  for (e = list_begin (&segments); e != list_end (&segments);
+       e = list_next (e)) {
+    struct shm_segment *seg = list_entry (e, struct shm_segment, elem);
+    if (strcmp (seg->name, name) == 0)
+      return seg;
+  }
+  return NULL;
+}
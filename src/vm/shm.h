@@ -0,0 +1,16 @@
+#ifndef VM_SHM_H
+#define VM_SHM_H
+
+#include <stdbool.h>
+#include "filesys/off_t.h"
+
+struct inode;
+
+/* Longest name of a shared memory segment. */
+#define SHM_NAME_MAX 14
+
+void shm_init (void);
+struct inode *shm_open_inode (const char *name, off_t size);
+bool shm_unlink_segment (const char *name);
+
+#endif /* vm/shm.h */
@@ -3,10 +3,12 @@
 #include "../threads/thread.h"
 #include "../userprog/pagedir.h"
 #include "../userprog/syscall.h"
+#include "../lib/user/syscall.h"
 #include "../lib/stddef.h"
 #include "../threads/malloc.h"
 #include "../lib/debug.h"
 #include "../threads/vaddr.h"
+#include "../devices/swap.h"
 
 bool spt_hash_less (const struct hash_elem *lhs,
 					 const struct hash_elem *rhs,
@@ -60,6 +62,7 @@ spt_destroy (spt *spt)
 	lock_acquire (&spt_lock);
 	hash_destroy (spt, spt_destroy_frame);
 	lock_release (&spt_lock);
+	free (spt);
 }
 
 /* Find the element with vaddr = upage in supplemental page table. */
@@ -68,16 +71,10 @@ spt_find (spt *spt, void *upage)
 {
   ASSERT (spt != NULL);
 
-	struct spte *spte;
-	struct hash_iterator it;
-	hash_first (&it, spt);
-	while (hash_next (&it)) {
-		spte = hash_entry (hash_cur (&it), struct spte, elem);
-		if (spte->vaddr == upage) {
-			return spte;
-		}
-	}
-	return NULL;
+	struct spte key;
+	key.vaddr = upage;
+	struct hash_elem *e = hash_find (spt, &key.elem);
+	return e != NULL ? hash_entry (e, struct spte, elem) : NULL;
 }
 
 /* Remove a hash_elem from spt. */
@@ -98,11 +95,19 @@ new_spte (void *upage)
 	
 	struct spte *spte = malloc (sizeof (struct spte));
 	if (spte == NULL) {
+	  lock_release (&spt_lock);
 	  return NULL;
 	}
 
 	spte->vaddr = upage;
 	spte->status = UNLOAD;
+	spte->value = NULL;
+	spte->writable = true;
+	spte->is_shared = false;
+	spte->se = NULL;
+	spte->merged = NULL;
+	spte->cow = NULL;
+	spte->advice = MADV_NORMAL;
 	hash_insert (spt, &spte->elem);
 	lock_release (&spt_lock);
 
@@ -138,5 +143,8 @@ void
 spt_destroy_frame (struct hash_elem *e, void *aux UNUSED) 
 {
 	struct spte *t = hash_entry (e, struct spte, elem);
+	if (t->status == SWAP) {
+		swap_drop ((size_t) t->value);
+	}
 	free(t);
 }
@@ -8,6 +8,8 @@
 #include "../threads/synch.h"
 #include "../vm/sharing.h"
 typedef struct hash spt;
+struct merged_page;
+struct cache_page;
 
 struct lock spt_lock;
 
@@ -40,6 +42,9 @@ struct spte {
   bool writable;
   bool is_shared;           /* If this page is shared. */
   struct sharing_entry *se; /* Corresponding sharing entry. */
+  struct merged_page *merged; /* Merged frame if is_shared by same-page. */
+  struct cache_page *cow;   /* Cached page read () mapped copy-on-write. */
+  int advice;               /* MADV_NORMAL, MADV_RANDOM or MADV_SEQUENTIAL. */
   struct hash_elem elem;
 };
 